@@ -3,12 +3,14 @@
 
 DS1603L::DS1603L(Stream &stream) {                              // General constructor.
   sensorSerial = &stream;
+  validFrames = 0;
 }
 
 void DS1603L::begin() {                                         // Initialisation of some variables.
   sensorStatus = DS1603L_NO_SENSOR_DETECTED;
   lastReadingTime = 0;
   serialData = 0;
+  validFrames = 0;
 }
 
 uint16_t DS1603L::readSensor() {
@@ -36,6 +38,7 @@ uint16_t DS1603L::readSensor() {
         reading = serialData >> 8 & 0xFFFF;                     // Byte 2 = data_H, byte 1 = data_L. Together they're the level in mm.
         sensorStatus = DS1603L_READING_SUCCESS;                 // Successful reading!
         lastReadingTime = millis();                             // Check when we had the latest successful reading. Sensor should transmit every 1-2 seconds.
+        validFrames++;
       }
       else {
         sensorStatus = DS1603L_READING_CHECKSUM_FAIL;           // Failed the checksum; returning previous reading.
@@ -55,3 +58,7 @@ uint8_t DS1603L::getStatus() {
   return sensorStatus;
 }
 
+uint32_t DS1603L::getValidFrames() {
+  return validFrames;
+}
+
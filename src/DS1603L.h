@@ -19,6 +19,7 @@ class DS1603L {
     void begin();                                               // Initialisation.
     uint16_t readSensor();                                      // Get the latest data from the Serial buffer and process it.
     uint8_t getStatus();                                        // Return the status of the sensor.
+    uint32_t getValidFrames();                                  // Return the number of frames that passed the checksum.
 
 
   private:
@@ -27,5 +28,6 @@ class DS1603L {
     uint32_t serialData;                                        // A 4-byte buffer to store the latest transmission data.
     int16_t reading;                                            // The latest reading as returned by the sensor: water level in mm.
     uint32_t lastReadingTime;                                   // When the last successful reading was received, to detect disconnection.
+    uint32_t validFrames;                                       // Frames that passed the checksum - tells a new reading from a stale status.
 };
 #endif
@@ -0,0 +1,104 @@
+#include "cbor_writer.h"
+
+// CBOR major types
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_SIMPLE 7
+
+CborWriter::CborWriter(uint8_t *buffer, size_t size)
+    : buffer(buffer), size(size), len(0), overflow(false)
+{
+}
+
+// Write a type/argument head using the shortest encoding
+void CborWriter::writeHead(uint8_t major_type, uint32_t value)
+{
+    uint8_t head[5];
+    size_t count;
+
+    major_type <<= 5;
+    if (value < 24)
+    {
+        head[0] = major_type | value;
+        count = 1;
+    }
+    else if (value <= 0xFF)
+    {
+        head[0] = major_type | 24;
+        head[1] = value;
+        count = 2;
+    }
+    else if (value <= 0xFFFF)
+    {
+        head[0] = major_type | 25;
+        head[1] = value >> 8;
+        head[2] = value;
+        count = 3;
+    }
+    else
+    {
+        head[0] = major_type | 26;
+        head[1] = value >> 24;
+        head[2] = value >> 16;
+        head[3] = value >> 8;
+        head[4] = value;
+        count = 5;
+    }
+
+    if (len + count > size)
+    {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + len, head, count);
+    len += count;
+}
+
+void CborWriter::beginMap(uint32_t pairs)
+{
+    writeHead(CBOR_MAP, pairs);
+}
+
+void CborWriter::beginArray(uint32_t items)
+{
+    writeHead(CBOR_ARRAY, items);
+}
+
+void CborWriter::addUInt(uint32_t value)
+{
+    writeHead(CBOR_UNSIGNED, value);
+}
+
+void CborWriter::addInt(int32_t value)
+{
+    if (value < 0)
+    {
+        writeHead(CBOR_NEGATIVE, (uint32_t)(-1 - value));
+    }
+    else
+    {
+        writeHead(CBOR_UNSIGNED, value);
+    }
+}
+
+void CborWriter::addBool(bool value)
+{
+    writeHead(CBOR_SIMPLE, value ? 21 : 20);
+}
+
+void CborWriter::addString(const char *value)
+{
+    size_t count = strlen(value);
+    writeHead(CBOR_TEXT, count);
+
+    if (len + count > size)
+    {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + len, value, count);
+    len += count;
+}
@@ -0,0 +1,43 @@
+/*
+ * CBOR Writer
+ *
+ * Minimal CBOR (RFC 8949) encoder that writes into a caller-supplied
+ * fixed buffer. Used for the compact binary MQTT payload; like
+ * JsonWriter it never allocates. Maps and arrays use definite lengths,
+ * so the caller passes the number of entries up front.
+ */
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class CborWriter
+{
+public:
+    CborWriter(uint8_t *buffer, size_t size);
+
+    void beginMap(uint32_t pairs);
+    void beginArray(uint32_t items);
+
+    void addUInt(uint32_t value);
+    void addInt(int32_t value);
+    void addBool(bool value);
+    void addString(const char *value);
+
+    const uint8_t *data() const { return buffer; }
+    size_t length() const { return len; }
+    bool overflowed() const { return overflow; } // True if the buffer was too small
+
+private:
+    void writeHead(uint8_t major_type, uint32_t value);
+
+    uint8_t *buffer;
+    size_t size;
+    size_t len;
+    bool overflow;
+};
+
+#endif // CBOR_WRITER_H
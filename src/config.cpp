@@ -0,0 +1,145 @@
+#include "config.h"
+#include "json_writer.h"
+
+// Active configuration, guarded by a spinlock so updates are seen all-or-nothing
+static runtime_config_t active_config;
+static portMUX_TYPE config_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Field table for parsing and validating command payloads
+struct config_field_t
+{
+    const char *key;
+    size_t offset;
+    uint32_t min;
+    uint32_t max;
+};
+
+static const config_field_t config_fields[] = {
+    {"sample_ms", offsetof(runtime_config_t, sample_ms), CONFIG_MIN_SAMPLE_MS, CONFIG_MAX_SAMPLE_MS},
+    {"filter", offsetof(runtime_config_t, filter), 1, CONFIG_MAX_FILTER},
+    {"deadband_mm", offsetof(runtime_config_t, deadband_mm), 0, CONFIG_MAX_DEADBAND_MM},
+    {"publish_ms", offsetof(runtime_config_t, publish_ms), 0, CONFIG_MAX_PUBLISH_MS},
+    {"status_ms", offsetof(runtime_config_t, status_ms), CONFIG_MIN_STATUS_MS, CONFIG_MAX_STATUS_MS},
+    {"loop_ms", offsetof(runtime_config_t, loop_ms), CONFIG_MIN_LOOP_MS, CONFIG_MAX_LOOP_MS},
+};
+
+#define CONFIG_FIELD_COUNT (sizeof(config_fields) / sizeof(config_fields[0]))
+
+// Initialize runtime configuration with defaults
+void config_init()
+{
+    active_config.sample_ms = CONFIG_DEFAULT_SAMPLE_MS;
+    active_config.filter = CONFIG_DEFAULT_FILTER;
+    active_config.deadband_mm = CONFIG_DEFAULT_DEADBAND_MM;
+    active_config.publish_ms = CONFIG_DEFAULT_PUBLISH_MS;
+    active_config.status_ms = CONFIG_DEFAULT_STATUS_MS;
+    active_config.loop_ms = CONFIG_DEFAULT_LOOP_MS;
+    active_config.version = 0;
+}
+
+// Get a consistent copy of the active configuration
+runtime_config_t get_runtime_config()
+{
+    portENTER_CRITICAL(&config_mux);
+    runtime_config_t config = active_config;
+    portEXIT_CRITICAL(&config_mux);
+    return config;
+}
+
+// Find "key": <number> in a flat JSON object, returns -1 if absent, 0 if malformed, 1 if found
+static int find_uint(const char *payload, size_t length, const char *key, uint32_t *value)
+{
+    size_t key_length = strlen(key);
+
+    for (size_t i = 0; i + key_length + 2 <= length; i++)
+    {
+        if (payload[i] != '"' || payload[i + key_length + 1] != '"' ||
+            memcmp(payload + i + 1, key, key_length) != 0)
+        {
+            continue;
+        }
+
+        size_t pos = i + key_length + 2;
+        while (pos < length && (payload[pos] == ' ' || payload[pos] == ':'))
+        {
+            pos++;
+        }
+
+        if (pos >= length || payload[pos] < '0' || payload[pos] > '9')
+        {
+            return 0;
+        }
+
+        uint32_t number = 0;
+        while (pos < length && payload[pos] >= '0' && payload[pos] <= '9')
+        {
+            if (number > 429496729)
+            {
+                return 0; // Would overflow
+            }
+            number = number * 10 + (payload[pos++] - '0');
+        }
+        *value = number;
+        return 1;
+    }
+    return -1;
+}
+
+// Apply a command payload like {"sample_ms":1000,"filter":5}; rejected as a whole if any value is invalid
+bool config_apply_json(const char *payload, size_t length)
+{
+    runtime_config_t updated = get_runtime_config();
+    bool changed = false;
+
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++)
+    {
+        const config_field_t &field = config_fields[i];
+        uint32_t value;
+        int found = find_uint(payload, length, field.key, &value);
+
+        if (found == 0 || (found > 0 && (value < field.min || value > field.max)))
+        {
+            Serial.print("Config: invalid value for ");
+            Serial.println(field.key);
+            return false;
+        }
+
+        if (found > 0)
+        {
+            *(uint32_t *)((uint8_t *)&updated + field.offset) = value;
+            changed = true;
+        }
+    }
+
+    if (!changed)
+    {
+        return false;
+    }
+
+    // Swap in the complete update at once
+    portENTER_CRITICAL(&config_mux);
+    updated.version = active_config.version + 1;
+    active_config = updated;
+    portEXIT_CRITICAL(&config_mux);
+
+    Serial.print("Config updated to version ");
+    Serial.println(updated.version);
+    return true;
+}
+
+// Serialize the active configuration
+size_t config_to_json(char *buffer, size_t size)
+{
+    runtime_config_t config = get_runtime_config();
+
+    JsonWriter json(buffer, size);
+    json.beginObject();
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++)
+    {
+        json.addUInt(config_fields[i].key, *(const uint32_t *)((const uint8_t *)&config + config_fields[i].offset));
+    }
+    json.addUInt("version", config.version);
+    json.endObject();
+
+    return json.overflowed() ? 0 : json.length();
+}
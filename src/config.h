@@ -0,0 +1,52 @@
+/*
+ * Runtime Configuration for NMEA0183 Level Sensor
+ *
+ * Sampling, filtering and publishing rates that can be changed at
+ * runtime over the MQTT command topic without a reboot. Updates are
+ * validated as a whole and swapped in atomically, so readers never see
+ * a half-applied configuration.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+
+// Defaults (previously hard-coded)
+#define CONFIG_DEFAULT_SAMPLE_MS 5000  // Sensor sampling interval
+#define CONFIG_DEFAULT_FILTER 10       // Moving average window (samples)
+#define CONFIG_DEFAULT_DEADBAND_MM 0   // Minimum change before publishing (0 = off)
+#define CONFIG_DEFAULT_PUBLISH_MS 0    // Minimum interval between data publishes (0 = every sample)
+#define CONFIG_DEFAULT_STATUS_MS 5000  // Interval between status publishes
+#define CONFIG_DEFAULT_LOOP_MS 50      // Sensor polling period (scheduler)
+
+// Limits for values received over the command topic
+#define CONFIG_MIN_SAMPLE_MS 100
+#define CONFIG_MAX_SAMPLE_MS 3600000
+#define CONFIG_MAX_FILTER 32
+#define CONFIG_MAX_DEADBAND_MM 1000
+#define CONFIG_MAX_PUBLISH_MS 3600000
+#define CONFIG_MIN_STATUS_MS 1000
+#define CONFIG_MAX_STATUS_MS 3600000
+#define CONFIG_MIN_LOOP_MS 5
+#define CONFIG_MAX_LOOP_MS 1000
+
+// Runtime configuration
+struct runtime_config_t
+{
+    uint32_t sample_ms;
+    uint32_t filter;
+    uint32_t deadband_mm;
+    uint32_t publish_ms;
+    uint32_t status_ms;
+    uint32_t loop_ms;
+    uint32_t version; // Incremented on every applied update
+};
+
+// Function declarations
+void config_init();
+runtime_config_t get_runtime_config();
+bool config_apply_json(const char *payload, size_t length);
+size_t config_to_json(char *buffer, size_t size);
+
+#endif // CONFIG_H
@@ -1,5 +1,13 @@
 #include "display.h"
+#include "power.h"
+#include "task_monitor.h"
+#include "history.h"
+#include <SPI.h>
 #include <WiFi.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 // Display configuration
 const uint16_t screenWidth = 240;
@@ -8,17 +16,14 @@ const uint16_t screenHeight = 320;
 // TFT instance
 TFT_eSPI tft = TFT_eSPI();
 
-// LVGL display buffer
-static lv_color_t buf[screenWidth * 10]; // Back to original size
+// LVGL render buffers - LVGL renders into one while the other is sent by DMA
+DMA_ATTR static uint16_t buf_a[screenWidth * DISPLAY_BUFFER_LINES];
+DMA_ATTR static uint16_t buf_b[screenWidth * DISPLAY_BUFFER_LINES];
 static lv_display_t *disp;
+static bool dma_enabled = false;
+static bool dma_active = false; // A transfer was started and not yet waited for
 
-// LVGL UI elements
-lv_obj_t *height_label;
-lv_obj_t *level_label;
-lv_obj_t *wifi_label;
-lv_obj_t *sensor_label;
-
-// Status bar elements
+// Status bar elements - on the top layer, shown over every screen
 lv_obj_t *status_bar;
 lv_obj_t *wifi_signal_label;
 lv_obj_t *wifi_status_label;
@@ -26,26 +31,314 @@ lv_obj_t *sensor_status_label;
 lv_obj_t *mqtt_status_label;
 lv_obj_t *time_label;
 
-// LVGL display flush function
+// Trend chart - only exists while this device's tank is shown
+static lv_obj_t *trend_chart = NULL;
+static lv_chart_series_t *trend_series = NULL;
+static uint32_t trend_seq = 0; // Newest history point on the chart
+
+// Screens - built when shown and deleted when left, so only one is in memory at a time
+enum display_screen_t
+{
+    DISPLAY_SCREEN_NONE,
+    DISPLAY_SCREEN_OVERVIEW, // Bar gauge per tank
+    DISPLAY_SCREEN_DETAIL    // Values, trend and sensor status of one tank
+};
+
+static display_screen_t pending_screen = DISPLAY_SCREEN_NONE; // Requested by a tap, built after the LVGL pass
+static int pending_tank = 0;
+static unsigned long switch_requested_us = 0;
+
+// View model - widgets observe these subjects and are only redrawn when a value changes
+static lv_subject_t height_subject[DISPLAY_TANK_COUNT];
+static lv_subject_t level_subject[DISPLAY_TANK_COUNT];
+static lv_subject_t sensor_ok_subject[DISPLAY_TANK_COUNT];
+static lv_subject_t wifi_connected_subject;
+static lv_subject_t wifi_bars_subject; // 0-4 signal bars
+static lv_subject_t mqtt_connected_subject;
+static lv_subject_t uptime_subject;    // Seconds
+static char wifi_ssid_text[12] = "WiFi"; // Read once per connection
+
+// Display update sent from the sensor/network side to the render task
+enum display_msg_type_t
+{
+    DISPLAY_MSG_VALUES,
+    DISPLAY_MSG_STATUS,
+    DISPLAY_MSG_TREND,
+    DISPLAY_MSG_TOUCH // From the PENIRQ interrupt, only wakes the render task
+};
+
+struct display_msg_t
+{
+    display_msg_type_t type;
+    unsigned long sent_us; // For queue latency
+    int tank;
+    int32_t height_mm;
+    int32_t level_percent;
+    bool sensor_ok;
+    bool wifi_connected;
+    bool mqtt_connected;
+    int32_t wifi_bars;
+    char ssid[12];
+    int16_t trend_point;
+    uint32_t trend_seq;
+};
+
+static QueueHandle_t display_queue = NULL;
+static TaskHandle_t display_task_handle = NULL;
+static std::atomic<uint32_t> queue_dropped(0); // Posted from the sensor (core 1) and network (core 0) tasks
+
+// Redraw statistics (current and last complete second)
+static uint32_t flushed_pixels = 0;
+static uint32_t flush_count = 0;
+static uint32_t render_us = 0;
+static uint32_t flush_wait_us = 0;
+static uint32_t frame_us_max = 0;
+static uint32_t latency_us_sum = 0;
+static uint32_t latency_us_max = 0;
+static uint32_t latency_count = 0;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long stats_window_start = 0;
+static display_stats_t last_stats = {};
+static uint32_t repair_count = 0;
+static uint32_t benchmark_frame_us = 0;
+static uint32_t benchmark_wait_us = 0;
+static uint32_t screen_switch_us = 0;
+static uint32_t screen_switch_us_max = 0;
+static uint32_t screen_heap_bytes = 0;
+
+// Touch input - the controller is only read between a PENIRQ edge and the release
+static SPIClass touch_spi(HSPI); // TFT_eSPI drives the display on VSPI
+static lv_indev_t *touch_indev = NULL;
+static volatile bool touch_active = false;  // Reads running, further edges are ignored
+static volatile bool touch_pending = false; // Edge seen, reads not started yet
+static volatile unsigned long touch_irq_us = 0;
+static bool touch_first_read = false;
+static lv_point_t touch_point = {0, 0};
+static uint32_t touch_reads = 0;
+static uint32_t touch_read_us_sum = 0;
+static uint32_t touch_read_us_max = 0;
+static uint32_t touch_wake_us = 0;
+static uint32_t touch_spurious = 0;
+
+// Self-check probe - a small block inside a widget, compared against what was last flushed there
+struct display_probe_t
+{
+    lv_obj_t *obj;
+    bool placed;   // Position is taken from the widget once the layout has been drawn
+    int32_t x;
+    int32_t y;
+    uint16_t expected[DISPLAY_PROBE_SIZE * DISPLAY_PROBE_SIZE];
+    uint16_t captured; // Bit per pixel, set when the pixel was flushed
+};
+
+#define DISPLAY_PROBE_COUNT 3
+#define DISPLAY_PROBE_ALL ((uint16_t)((1UL << (DISPLAY_PROBE_SIZE * DISPLAY_PROBE_SIZE)) - 1))
+static display_probe_t probes[DISPLAY_PROBE_COUNT] = {};
+
+// Point a self-check probe at a widget, NULL while the screen has none
+static void set_probe(int i, lv_obj_t *obj)
+{
+    probes[i].obj = obj;
+    probes[i].placed = false;
+    probes[i].captured = 0;
+}
+
+// Record the pixels flushed over the self-check probes
+static void capture_probes(const lv_area_t *area, const uint16_t *pixels)
+{
+    int32_t w = area->x2 - area->x1 + 1;
+
+    for (int i = 0; i < DISPLAY_PROBE_COUNT; i++)
+    {
+        display_probe_t *probe = &probes[i];
+        if (!probe->placed)
+        {
+            continue;
+        }
+
+        for (int py = 0; py < DISPLAY_PROBE_SIZE; py++)
+        {
+            int32_t y = probe->y + py;
+            if (y < area->y1 || y > area->y2)
+            {
+                continue;
+            }
+            for (int px = 0; px < DISPLAY_PROBE_SIZE; px++)
+            {
+                int32_t x = probe->x + px;
+                if (x < area->x1 || x > area->x2)
+                {
+                    continue;
+                }
+                int bit = py * DISPLAY_PROBE_SIZE + px;
+                uint16_t pixel = pixels[(y - area->y1) * w + (x - area->x1)];
+                probe->expected[bit] = (pixel >> 8) | (pixel << 8); // Buffer is in panel byte order
+                probe->captured |= 1 << bit;
+            }
+        }
+    }
+}
+
+// Wait for the DMA transfer in progress and release the SPI bus
+static void display_dma_wait()
+{
+    if (!dma_active)
+    {
+        return;
+    }
+
+    unsigned long start = micros();
+    tft.dmaWait();
+    tft.endWrite();
+    flush_wait_us += micros() - start;
+
+    dma_active = false;
+    power_unlock(POWER_LOCK_FLUSH);
+}
+
+// LVGL display flush function - starts the transfer and returns, LVGL renders the next stripe meanwhile
 void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *color_p)
 {
     uint32_t w = (area->x2 - area->x1 + 1);
     uint32_t h = (area->y2 - area->y1 + 1);
 
+#if LVGL_VERSION_MAJOR == 9 && LVGL_VERSION_MINOR < 3
+    // No RGB565_SWAPPED render format before LVGL 9.3 - swap in software
+    lv_draw_sw_rgb565_swap(color_p, w * h);
+#endif
+
+    if (DISPLAY_SELF_CHECK_INTERVAL > 0)
+    {
+        capture_probes(area, (const uint16_t *)color_p);
+    }
+
+    flushed_pixels += w * h;
+    flush_count++;
+
+    power_lock(POWER_LOCK_FLUSH);
+
+    if (!dma_enabled)
+    {
+        unsigned long start = micros();
+        tft.startWrite();
+        tft.setAddrWindow(area->x1, area->y1, w, h);
+        tft.pushPixels(color_p, w * h);
+        tft.endWrite();
+        flush_wait_us += micros() - start;
+
+        power_unlock(POWER_LOCK_FLUSH);
+        lv_display_flush_ready(disp);
+        return;
+    }
+
+    // The buffer is already in panel byte order, so it is sent without a copy
     tft.startWrite();
-    tft.setAddrWindow(area->x1, area->y1, w, h);
-    tft.pushColors((uint16_t *)color_p, w * h, true);
-    tft.endWrite();
+    tft.pushImageDMA(area->x1, area->y1, w, h, (uint16_t *)color_p);
+    dma_active = true;
+}
+
+// LVGL flush wait function - called before LVGL reuses a buffer that may still be on the wire
+void my_disp_flush_wait(lv_display_t *disp)
+{
+    display_dma_wait();
+}
+
+// PENIRQ falling edge - wakes the render task, the controller is read there
+static void IRAM_ATTR touch_isr()
+{
+    // PENIRQ also toggles during every conversion while the panel is held
+    if (touch_active)
+    {
+        return;
+    }
+    touch_active = true;
+    touch_irq_us = micros();
+    touch_pending = true;
 
-    lv_display_flush_ready(disp);
+    // The flag is what starts the reads, the message only wakes the task. If the queue is full the
+    // task is not sleeping on it, and display_loop() sees the flag on its next pass.
+    display_msg_t msg = {DISPLAY_MSG_TOUCH};
+    msg.sent_us = touch_irq_us;
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(display_queue, &msg, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// One XPT2046 conversion - 12-bit result
+static int32_t touch_convert(uint8_t command)
+{
+    touch_spi.transfer(command);
+    return touch_spi.transfer16(0) >> 3;
 }
 
-// Touch screen support (optional - simplified for now)
+// Read the touch position in screen coordinates - returns false if the pressure is below the threshold
+static bool touch_read(int32_t *x, int32_t *y)
+{
+    touch_spi.beginTransaction(SPISettings(TOUCH_SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+    digitalWrite(TOUCH_CS_PIN, LOW);
+    int32_t z = touch_convert(0xB1) + 4095 - touch_convert(0xC1);
+    touch_convert(0x91); // First position sample after the pressure reads is noisy
+    int32_t raw_y = touch_convert(0x91);
+    int32_t raw_x = touch_convert(0xD0); // PD = 00: power down between conversions with PENIRQ enabled
+    digitalWrite(TOUCH_CS_PIN, HIGH);
+    touch_spi.endTransaction();
+
+    if (TOUCH_LOG_RAW)
+    {
+        Serial.printf("Touch raw x %ld y %ld z %ld\n", (long)raw_x, (long)raw_y, (long)z);
+    }
+
+    if (z < TOUCH_THRESHOLD)
+    {
+        return false;
+    }
+
+    int32_t raw_h = TOUCH_SWAP_XY ? raw_y : raw_x;
+    int32_t raw_v = TOUCH_SWAP_XY ? raw_x : raw_y;
+    *x = constrain(map(raw_h, TOUCH_X_RAW_LEFT, TOUCH_X_RAW_RIGHT, 0, screenWidth - 1), 0, screenWidth - 1);
+    *y = constrain(map(raw_v, TOUCH_Y_RAW_TOP, TOUCH_Y_RAW_BOTTOM, 0, screenHeight - 1), 0, screenHeight - 1);
+    return true;
+}
+
+// LVGL touch read - only runs between a PENIRQ edge and the release, so an idle panel costs no SPI traffic
 void my_touchpad_read(lv_indev_t *indev_driver, lv_indev_data_t *data)
 {
-    // For now, just return no touch
-    // TODO: Implement proper touch reading if touch screen is connected
-    data->state = LV_INDEV_STATE_REL;
+    // The controller has its own bus, so reads never wait for a display flush
+    unsigned long start = micros();
+    int32_t x, y;
+    bool pressed = touch_read(&x, &y);
+    uint32_t read_us = micros() - start;
+
+    touch_reads++;
+    touch_read_us_sum += read_us;
+    if (read_us > touch_read_us_max)
+    {
+        touch_read_us_max = read_us;
+    }
+    if (touch_first_read)
+    {
+        touch_first_read = false;
+        touch_wake_us = start - touch_irq_us;
+        if (!pressed)
+        {
+            touch_spurious++; // GPIO 36 can see short glitches when the ADC or WiFi powers up
+        }
+    }
+
+    if (pressed)
+    {
+        touch_point.x = x;
+        touch_point.y = y;
+    }
+    data->point = touch_point;
+    data->state = pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+
+    // Released - stop reading until the next edge
+    if (!pressed)
+    {
+        lv_timer_pause(lv_indev_get_read_timer(indev_driver));
+        touch_active = false;
+    }
 }
 
 // Initialize display hardware
@@ -56,32 +349,65 @@ void display_init()
     tft.setRotation(0);
     tft.fillScreen(TFT_BLACK);
 
+    // DMA transfers for LVGL flushes - falls back to blocking writes if unavailable
+    dma_enabled = tft.initDMA();
+    if (!dma_enabled)
+    {
+        Serial.println("Display DMA not available, using blocking SPI writes");
+    }
+
+    // Touch controller on its own SPI bus
+    pinMode(TOUCH_CS_PIN, OUTPUT);
+    digitalWrite(TOUCH_CS_PIN, HIGH);
+    touch_spi.begin(TOUCH_CLK_PIN, TOUCH_MISO_PIN, TOUCH_MOSI_PIN, TOUCH_CS_PIN);
+
     // Set backlight
     pinMode(TFT_BL, OUTPUT);
     digitalWrite(TFT_BL, HIGH);
 }
 
+// LVGL tick source
+static uint32_t lvgl_tick()
+{
+    return millis();
+}
+
 // Initialize LVGL display
 void lvgl_init()
 {
     lv_init();
 
-    // Create display with buffer
+    // LVGL 9 ignores LV_TICK_CUSTOM in lv_conf.h - without a tick source its timers never run
+    lv_tick_set_cb(lvgl_tick);
+
+    // Create display with two buffers, rendered directly in the panel's big-endian RGB565 order
     disp = lv_display_create(screenWidth, screenHeight);
     lv_display_set_flush_cb(disp, my_disp_flush);
-    lv_display_set_buffers(disp, buf, NULL, sizeof(buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_wait_cb(disp, my_disp_flush_wait);
+#if LVGL_VERSION_MAJOR > 9 || LVGL_VERSION_MINOR >= 3
+    lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565_SWAPPED);
+#endif
+    lv_display_set_buffers(disp, buf_a, buf_b, sizeof(buf_a), LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+    // Initialize touch input - read timer is paused until the panel is touched
+    touch_indev = lv_indev_create();
+    lv_indev_set_type(touch_indev, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(touch_indev, my_touchpad_read);
+    lv_timer_pause(lv_indev_get_read_timer(touch_indev));
 
-    // Initialize touch input (optional)
-    lv_indev_t *indev = lv_indev_create();
-    lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
-    lv_indev_set_read_cb(indev, my_touchpad_read);
+    // Updates from loop() to the render task
+    display_queue = xQueueCreate(DISPLAY_QUEUE_LENGTH, sizeof(display_msg_t));
+
+    // GPIO 36 is input-only without pull-ups, the board pulls PENIRQ up
+    pinMode(TOUCH_IRQ_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ_PIN), touch_isr, FALLING);
 }
 
 // Create status bar at top of screen
 void create_status_bar()
 {
     // Create status bar container
-    status_bar = lv_obj_create(lv_scr_act());
+    status_bar = lv_obj_create(lv_layer_top());
     lv_obj_set_size(status_bar, screenWidth, 25);
     lv_obj_align(status_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_set_style_bg_color(status_bar, lv_color_hex(0x1F1F1F), 0);
@@ -121,18 +447,36 @@ void create_status_bar()
 }
 
 // Get WiFi signal strength icon
-const char *get_wifi_signal_icon(int32_t rssi)
+const char *get_wifi_signal_icon(int32_t bars)
 {
-    if (rssi > -50)
+    switch (bars)
+    {
+    case 4:
         return "***"; // Excellent signal (3 bars)
-    else if (rssi > -60)
+    case 3:
         return "** "; // Good signal (2 bars)
-    else if (rssi > -70)
+    case 2:
         return "*  "; // Fair signal (1 bar)
-    else if (rssi > -80)
+    case 1:
         return ".  "; // Weak signal (dot)
-    else
+    default:
         return "X  "; // Very weak/no signal
+    }
+}
+
+// Convert signal strength to bars
+static int32_t get_wifi_signal_bars(int32_t rssi)
+{
+    if (rssi > -50)
+        return 4;
+    else if (rssi > -60)
+        return 3;
+    else if (rssi > -70)
+        return 2;
+    else if (rssi > -80)
+        return 1;
+    else
+        return 0;
 }
 
 // Get sensor status icon
@@ -141,164 +485,755 @@ const char *get_sensor_status_icon(bool sensor_ok)
     return sensor_ok ? "OK" : "ERR";
 }
 
-// Update status bar
+// Status colour for a connected/ok flag
+static lv_color_t get_status_color(bool ok)
+{
+    return lv_color_hex(ok ? 0x00FF00 : 0xFF0000);
+}
+
+// Update a subject only if the value changed - LVGL notifies observers on every set
+static void view_set(lv_subject_t *subject, int32_t value)
+{
+    if (lv_subject_get_int(subject) != value)
+    {
+        lv_subject_set_int(subject, value);
+    }
+}
+
+// Observer: numeric value label, "---" until the first reading
+static void value_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    int32_t value = lv_subject_get_int(subject);
+    if (value == DISPLAY_NO_VALUE)
+    {
+        lv_label_set_text(lv_observer_get_target_obj(observer), "---");
+    }
+    else
+    {
+        lv_label_set_text_fmt(lv_observer_get_target_obj(observer), "%d", (int)value);
+    }
+}
+
+// Observer: level gauge, empty until the first reading
+static void bar_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    int32_t value = lv_subject_get_int(subject);
+    lv_bar_set_value(lv_observer_get_target_obj(observer), value == DISPLAY_NO_VALUE ? 0 : value, LV_ANIM_OFF);
+}
+
+// Observer: level percentage under a gauge
+static void percent_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    int32_t value = lv_subject_get_int(subject);
+    if (value == DISPLAY_NO_VALUE)
+    {
+        lv_label_set_text(lv_observer_get_target_obj(observer), "---");
+    }
+    else
+    {
+        lv_label_set_text_fmt(lv_observer_get_target_obj(observer), "%d%%", (int)value);
+    }
+}
+
+// Observer: sensor status in the detail view
+static void sensor_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    lv_obj_t *label = lv_observer_get_target_obj(observer);
+    bool sensor_ok = lv_subject_get_int(subject);
+    lv_label_set_text(label, sensor_ok ? "Sensor: OK" : "Sensor: Error");
+    lv_obj_set_style_text_color(label, get_status_color(sensor_ok), 0);
+}
+
+// Observer: sensor status in the status bar
+static void sensor_status_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    lv_obj_t *label = lv_observer_get_target_obj(observer);
+    bool sensor_ok = lv_subject_get_int(subject);
+    lv_label_set_text(label, get_sensor_status_icon(sensor_ok));
+    lv_obj_set_style_text_color(label, get_status_color(sensor_ok), 0);
+}
+
+// Observer: WiFi name, or "No WiFi"
+static void wifi_status_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    lv_obj_t *label = lv_observer_get_target_obj(observer);
+    bool connected = lv_subject_get_int(subject);
+    lv_label_set_text(label, connected ? wifi_ssid_text : "No WiFi");
+    lv_obj_set_style_text_color(label, get_status_color(connected), 0);
+}
+
+// Observer: WiFi signal icon (colour follows the connection)
+static void wifi_signal_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    lv_obj_t *label = lv_observer_get_target_obj(observer);
+    bool connected = lv_subject_get_int(&wifi_connected_subject);
+    lv_label_set_text(label, connected ? get_wifi_signal_icon(lv_subject_get_int(&wifi_bars_subject)) : "X  ");
+    lv_obj_set_style_text_color(label, get_status_color(connected), 0);
+}
+
+// Observer: MQTT status
+static void mqtt_status_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    lv_obj_t *label = lv_observer_get_target_obj(observer);
+    bool connected = lv_subject_get_int(subject);
+    lv_label_set_text(label, connected ? "MQTT" : "No MQTT");
+    lv_obj_set_style_text_color(label, get_status_color(connected), 0);
+}
+
+// Observer: uptime as minutes:seconds
+static void uptime_observer(lv_observer_t *observer, lv_subject_t *subject)
+{
+    uint32_t uptime = lv_subject_get_int(subject);
+    lv_label_set_text_fmt(lv_observer_get_target_obj(observer), "%02lu:%02lu",
+                          (unsigned long)((uptime / 60) % 60), (unsigned long)(uptime % 60));
+}
+
+// Send an update to the render task - returns false if the queue is full
+static bool display_post(display_msg_t *msg)
+{
+    msg->sent_us = micros();
+    if (!display_queue || xQueueSend(display_queue, msg, 0) != pdTRUE)
+    {
+        queue_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// Update status bar - posts to the render task when something changed
 void update_status_bar(bool wifi_connected, bool sensor_ok, bool mqtt_connected)
 {
-    static char time_text[10];
+    static display_msg_t last = {DISPLAY_MSG_STATUS};
+    static unsigned long last_rssi_read = 0;
+    static char ssid_text[12] = "WiFi";
+    static int32_t wifi_bars = 0;
+    static bool was_connected = false;
 
-    // Update WiFi status
     if (wifi_connected)
     {
-        int32_t rssi = WiFi.RSSI();
-        lv_label_set_text(wifi_signal_label, get_wifi_signal_icon(rssi));
-        lv_obj_set_style_text_color(wifi_signal_label, lv_color_hex(0x00FF00), 0);
-
-        // Show SSID or "WiFi" if SSID is too long
-        String ssid = WiFi.SSID();
-        if (ssid.length() > 8)
+        // SSID only changes with a new connection - read it once instead of every loop
+        if (!was_connected)
         {
-            lv_label_set_text(wifi_status_label, "WiFi");
+            String ssid = WiFi.SSID();
+            strlcpy(ssid_text, ssid.length() > 8 ? "WiFi" : ssid.c_str(), sizeof(ssid_text));
+            last_rssi_read = 0;
         }
-        else
+
+        // Signal strength only needs to be current to within a few seconds
+        if (last_rssi_read == 0 || millis() - last_rssi_read >= DISPLAY_RSSI_INTERVAL)
         {
-            lv_label_set_text(wifi_status_label, ssid.c_str());
+            last_rssi_read = millis() | 1;
+            wifi_bars = get_wifi_signal_bars(WiFi.RSSI());
         }
-        lv_obj_set_style_text_color(wifi_status_label, lv_color_hex(0x00FF00), 0);
     }
-    else
+    was_connected = wifi_connected;
+
+    if (wifi_connected == last.wifi_connected && sensor_ok == last.sensor_ok &&
+        mqtt_connected == last.mqtt_connected && wifi_bars == last.wifi_bars &&
+        strcmp(ssid_text, last.ssid) == 0)
     {
-        lv_label_set_text(wifi_signal_label, "X  ");
-        lv_obj_set_style_text_color(wifi_signal_label, lv_color_hex(0xFF0000), 0);
-        lv_label_set_text(wifi_status_label, "No WiFi");
-        lv_obj_set_style_text_color(wifi_status_label, lv_color_hex(0xFF0000), 0);
+        return;
     }
 
-    // Update sensor status
-    lv_label_set_text(sensor_status_label, get_sensor_status_icon(sensor_ok));
-    if (sensor_ok)
+    display_msg_t msg = {DISPLAY_MSG_STATUS};
+    msg.wifi_connected = wifi_connected;
+    msg.sensor_ok = sensor_ok;
+    msg.mqtt_connected = mqtt_connected;
+    msg.wifi_bars = wifi_bars;
+    strlcpy(msg.ssid, ssid_text, sizeof(msg.ssid));
+
+    // Only remember what was actually delivered, so a dropped update is sent again
+    if (display_post(&msg))
     {
-        lv_obj_set_style_text_color(sensor_status_label, lv_color_hex(0x00FF00), 0);
+        last = msg;
     }
-    else
+}
+
+// Update uptime display (render task)
+void update_uptime()
+{
+    view_set(&uptime_subject, millis() / 1000);
+}
+
+// Chart value for a history point
+static int32_t trend_value(int16_t point)
+{
+    return point == HISTORY_NO_VALUE ? LV_CHART_POINT_NONE : point;
+}
+
+// Append a history point to the trend chart
+void display_add_trend_point(int16_t point, uint32_t seq)
+{
+    display_msg_t msg = {DISPLAY_MSG_TREND};
+    msg.trend_point = point;
+    msg.trend_seq = seq;
+    display_post(&msg);
+}
+
+// Apply an update in the render task
+static void display_apply(const display_msg_t *msg)
+{
+    if (msg->type == DISPLAY_MSG_TOUCH)
     {
-        lv_obj_set_style_text_color(sensor_status_label, lv_color_hex(0xFF0000), 0);
+        return; // Handled through touch_pending
     }
 
-    // Update MQTT status
-    if (mqtt_connected)
+    if (msg->type == DISPLAY_MSG_TREND)
     {
-        lv_label_set_text(mqtt_status_label, "MQTT");
-        lv_obj_set_style_text_color(mqtt_status_label, lv_color_hex(0x00FF00), 0);
+        // Circular mode overwrites the oldest point and only invalidates the columns around it.
+        // Without a chart the point is only in the history, which fills the chart when it is built.
+        // A point stored before the chart was built is already on it from the replay.
+        if (trend_chart && msg->trend_seq > trend_seq)
+        {
+            trend_seq = msg->trend_seq;
+            lv_chart_set_next_value(trend_chart, trend_series, trend_value(msg->trend_point));
+        }
+        return;
     }
-    else
+
+    if (msg->type == DISPLAY_MSG_VALUES)
+    {
+        view_set(&height_subject[msg->tank], msg->height_mm);
+        view_set(&level_subject[msg->tank], msg->level_percent);
+        view_set(&sensor_ok_subject[msg->tank], msg->sensor_ok);
+        return;
+    }
+
+    // The SSID is set before the connected flag so its observer shows the new name
+    if (msg->wifi_connected && strcmp(wifi_ssid_text, msg->ssid) != 0)
     {
-        lv_label_set_text(mqtt_status_label, "No MQTT");
-        lv_obj_set_style_text_color(mqtt_status_label, lv_color_hex(0xFF0000), 0);
+        strlcpy(wifi_ssid_text, msg->ssid, sizeof(wifi_ssid_text));
+        if (lv_subject_get_int(&wifi_connected_subject))
+        {
+            lv_subject_notify(&wifi_connected_subject);
+        }
     }
 
-    // Update time (show uptime in minutes:seconds)
-    unsigned long uptime = millis() / 1000;
-    unsigned long minutes = (uptime / 60) % 60;
-    unsigned long seconds = uptime % 60;
-    sprintf(time_text, "%02lu:%02lu", minutes, seconds);
-    lv_label_set_text(time_label, time_text);
+    view_set(&wifi_bars_subject, msg->wifi_bars);
+    view_set(&wifi_connected_subject, msg->wifi_connected);
+    view_set(&sensor_ok_subject[DISPLAY_LOCAL_TANK], msg->sensor_ok);
+    view_set(&mqtt_connected_subject, msg->mqtt_connected);
 }
 
-// Update uptime display
-void update_uptime()
+// Set up the view model and bind the status bar - screens bind their own widgets when built
+static void bind_view_model()
 {
-    static char time_text[10];
-    unsigned long uptime = millis() / 1000;
-    unsigned long minutes = (uptime / 60) % 60;
-    unsigned long seconds = uptime % 60;
-    sprintf(time_text, "%02lu:%02lu", minutes, seconds);
-    lv_label_set_text(time_label, time_text);
+    for (int i = 0; i < DISPLAY_TANK_COUNT; i++)
+    {
+        lv_subject_init_int(&height_subject[i], DISPLAY_NO_VALUE);
+        lv_subject_init_int(&level_subject[i], DISPLAY_NO_VALUE);
+        lv_subject_init_int(&sensor_ok_subject[i], 0);
+    }
+    lv_subject_init_int(&wifi_connected_subject, 0);
+    lv_subject_init_int(&wifi_bars_subject, 0);
+    lv_subject_init_int(&mqtt_connected_subject, 0);
+    lv_subject_init_int(&uptime_subject, 0);
+
+    lv_subject_add_observer_obj(&sensor_ok_subject[DISPLAY_LOCAL_TANK], sensor_status_observer, sensor_status_label, NULL);
+    lv_subject_add_observer_obj(&wifi_connected_subject, wifi_status_observer, wifi_status_label, NULL);
+    lv_subject_add_observer_obj(&wifi_connected_subject, wifi_signal_observer, wifi_signal_label, NULL);
+    lv_subject_add_observer_obj(&wifi_bars_subject, wifi_signal_observer, wifi_signal_label, NULL);
+    lv_subject_add_observer_obj(&mqtt_connected_subject, mqtt_status_observer, mqtt_status_label, NULL);
+    lv_subject_add_observer_obj(&uptime_subject, uptime_observer, time_label, NULL);
 }
 
-// Create the UI layout
-void create_ui()
+// Create the level trend chart, filled from the stored history
+static void create_trend_chart(lv_obj_t *parent)
 {
-    // First create the status bar at the top
-    create_status_bar();
+    trend_chart = lv_chart_create(parent);
+    lv_obj_set_size(trend_chart, 204, 110);
+    lv_obj_set_style_pad_all(trend_chart, 4, 0);
+    lv_chart_set_type(trend_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_update_mode(trend_chart, LV_CHART_UPDATE_MODE_CIRCULAR);
+    lv_chart_set_point_count(trend_chart, HISTORY_POINTS);
+#if LVGL_VERSION_MAJOR > 9 || LVGL_VERSION_MINOR >= 3
+    lv_chart_set_axis_range(trend_chart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+#else
+    lv_chart_set_range(trend_chart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+#endif
+    lv_chart_set_div_line_count(trend_chart, 3, 0);
+    lv_obj_set_style_size(trend_chart, 0, 0, LV_PART_INDICATOR); // Line only, no point markers
+
+    trend_series = lv_chart_add_series(trend_chart, lv_palette_main(LV_PALETTE_BLUE), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_all_value(trend_chart, trend_series, LV_CHART_POINT_NONE);
 
-    // Create the main container for content (positioned below status bar)
-    lv_obj_t *main_cont = lv_obj_create(lv_scr_act());
+    // Replay the stored history - later points are appended one at a time
+    static int16_t points[HISTORY_POINTS];
+    int count = history_get_points(points, HISTORY_POINTS, &trend_seq);
+    for (int i = 0; i < count; i++)
+    {
+        lv_chart_set_next_value(trend_chart, trend_series, trend_value(points[i]));
+    }
+}
+
+static void request_screen(display_screen_t screen, int tank);
+
+// Touch on a tank gauge - opens the tank's detail screen
+static void tank_clicked(lv_event_t *e)
+{
+    request_screen(DISPLAY_SCREEN_DETAIL, (int)(intptr_t)lv_event_get_user_data(e));
+}
+
+// Touch on the back button - returns to the overview
+static void back_clicked(lv_event_t *e)
+{
+    request_screen(DISPLAY_SCREEN_OVERVIEW, 0);
+}
+
+// Content area below the status bar
+static lv_obj_t *create_main_cont(lv_obj_t *screen)
+{
+    lv_obj_t *main_cont = lv_obj_create(screen);
     lv_obj_set_size(main_cont, 220, 270);            // Reduced height to account for status bar
     lv_obj_align(main_cont, LV_ALIGN_CENTER, 0, 15); // Offset down by status bar height
+    lv_obj_set_style_pad_all(main_cont, 8, 0);
+    return main_cont;
+}
+
+// Create the overview screen - one bar gauge per tank, tap a gauge for its details
+static lv_obj_t *create_overview_screen()
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *main_cont = create_main_cont(screen);
 
     // Title
     lv_obj_t *title = lv_label_create(main_cont);
-    lv_label_set_text(title, "NMEA Level Sensor");
+    lv_label_set_text(title, "Tanks");
     lv_obj_set_style_text_font(title, &lv_font_montserrat_14, 0);
-    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 0);
+
+    // Gauges side by side
+    lv_obj_t *row = lv_obj_create(main_cont);
+    lv_obj_set_size(row, 204, 228);
+    lv_obj_align(row, LV_ALIGN_TOP_MID, 0, 26);
+    lv_obj_set_style_pad_all(row, 0, 0);
+    lv_obj_set_style_pad_column(row, 6, 0);
+    lv_obj_set_style_border_width(row, 0, 0);
+    lv_obj_remove_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(row, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    for (int i = 0; i < DISPLAY_TANK_COUNT; i++)
+    {
+        // The whole column is the touch target - labels and bar do not take clicks
+        lv_obj_t *gauge = lv_obj_create(row);
+        lv_obj_set_height(gauge, LV_PCT(100));
+        lv_obj_set_flex_grow(gauge, 1);
+        lv_obj_set_style_pad_all(gauge, 4, 0);
+        lv_obj_remove_flag(gauge, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_flex_flow(gauge, LV_FLEX_FLOW_COLUMN);
+        lv_obj_set_flex_align(gauge, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+        lv_obj_add_event_cb(gauge, tank_clicked, LV_EVENT_CLICKED, (void *)(intptr_t)i);
+
+        lv_obj_t *name = lv_label_create(gauge);
+        lv_label_set_text_fmt(name, "Tank %d", i + 1);
+
+        lv_obj_t *bar = lv_bar_create(gauge);
+        lv_obj_set_width(bar, 24);
+        lv_obj_set_flex_grow(bar, 1); // Taller than wide, so LVGL draws it vertically
+        lv_bar_set_range(bar, 0, 100);
+
+        lv_obj_t *value = lv_label_create(gauge);
+        lv_obj_set_style_text_font(value, &lv_font_montserrat_14, 0);
+
+        lv_subject_add_observer_obj(&level_subject[i], bar_observer, bar, NULL);
+        lv_subject_add_observer_obj(&level_subject[i], percent_observer, value, NULL);
+
+        if (i == 0)
+        {
+            set_probe(1, gauge);
+        }
+    }
+
+    return screen;
+}
+
+// Create the detail screen of one tank
+static lv_obj_t *create_detail_screen(int tank)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_t *main_cont = create_main_cont(screen);
+
+    // Title
+    lv_obj_t *title = lv_label_create(main_cont);
+    if (DISPLAY_TANK_COUNT > 1)
+    {
+        lv_label_set_text_fmt(title, "Tank %d", tank + 1);
+    }
+    else
+    {
+        lv_label_set_text(title, "NMEA Level Sensor");
+    }
+    lv_obj_set_style_text_font(title, &lv_font_montserrat_14, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 0);
+
+    // Back to the overview
+    lv_obj_t *back = lv_button_create(main_cont);
+    lv_obj_set_size(back, 28, 20);
+    lv_obj_set_style_pad_all(back, 0, 0);
+    lv_obj_align(back, LV_ALIGN_TOP_LEFT, 0, -2);
+    lv_obj_add_event_cb(back, back_clicked, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *back_label = lv_label_create(back);
+    lv_label_set_text(back_label, LV_SYMBOL_LEFT);
+    lv_obj_align(back_label, LV_ALIGN_CENTER, 0, 0);
 
     // Height display
     lv_obj_t *height_cont = lv_obj_create(main_cont);
-    lv_obj_set_size(height_cont, 200, 60);
-    lv_obj_align(height_cont, LV_ALIGN_TOP_MID, 0, 50);
+    lv_obj_set_size(height_cont, 204, 40);
+    lv_obj_set_style_pad_all(height_cont, 6, 0);
+    lv_obj_align(height_cont, LV_ALIGN_TOP_MID, 0, 22);
 
     lv_obj_t *height_title = lv_label_create(height_cont);
     lv_label_set_text(height_title, "Height [mm]:");
-    lv_obj_align(height_title, LV_ALIGN_TOP_LEFT, 5, 5);
+    lv_obj_align(height_title, LV_ALIGN_LEFT_MID, 0, 0);
 
-    height_label = lv_label_create(height_cont);
-    lv_label_set_text(height_label, "---");
+    lv_obj_t *height_label = lv_label_create(height_cont);
     lv_obj_set_style_text_font(height_label, &lv_font_montserrat_14, 0);
-    lv_obj_align(height_label, LV_ALIGN_BOTTOM_RIGHT, -5, -5);
+    lv_obj_align(height_label, LV_ALIGN_RIGHT_MID, 0, 0);
 
     // Level display
     lv_obj_t *level_cont = lv_obj_create(main_cont);
-    lv_obj_set_size(level_cont, 200, 60);
-    lv_obj_align(level_cont, LV_ALIGN_TOP_MID, 0, 120);
+    lv_obj_set_size(level_cont, 204, 40);
+    lv_obj_set_style_pad_all(level_cont, 6, 0);
+    lv_obj_align(level_cont, LV_ALIGN_TOP_MID, 0, 68);
 
     lv_obj_t *level_title = lv_label_create(level_cont);
     lv_label_set_text(level_title, "Level [%]:");
-    lv_obj_align(level_title, LV_ALIGN_TOP_LEFT, 5, 5);
+    lv_obj_align(level_title, LV_ALIGN_LEFT_MID, 0, 0);
 
-    level_label = lv_label_create(level_cont);
-    lv_label_set_text(level_label, "---");
+    lv_obj_t *level_label = lv_label_create(level_cont);
     lv_obj_set_style_text_font(level_label, &lv_font_montserrat_14, 0);
-    lv_obj_align(level_label, LV_ALIGN_BOTTOM_RIGHT, -5, -5);
+    lv_obj_align(level_label, LV_ALIGN_RIGHT_MID, 0, 0);
+
+    // Level trend - one point per history bucket, kept for this device's tank only
+    if (tank == DISPLAY_LOCAL_TANK)
+    {
+        create_trend_chart(main_cont);
+        lv_obj_align(trend_chart, LV_ALIGN_TOP_MID, 0, 114);
+    }
 
     // Sensor status
-    sensor_label = lv_label_create(main_cont);
-    lv_label_set_text(sensor_label, "Sensor: Initializing...");
-    lv_obj_align(sensor_label, LV_ALIGN_TOP_MID, 0, 200);
+    lv_obj_t *sensor_label = lv_label_create(main_cont);
+    lv_obj_align(sensor_label, LV_ALIGN_TOP_MID, 0, 232);
+
+    // Adding an observer sets the current value - they are removed again when the screen is deleted
+    lv_subject_add_observer_obj(&height_subject[tank], value_observer, height_label, NULL);
+    lv_subject_add_observer_obj(&level_subject[tank], value_observer, level_label, NULL);
+    lv_subject_add_observer_obj(&sensor_ok_subject[tank], sensor_observer, sensor_label, NULL);
+
+    // Self-check probes sit inside the regions that change at runtime
+    set_probe(1, height_cont);
+    set_probe(2, level_cont);
+
+    return screen;
+}
+
+// Replace the active screen - the old one is deleted before the new one is built, so they never
+// take memory at the same time
+static void show_screen(display_screen_t screen, int tank)
+{
+    // Drop references into the old screen
+    lv_obj_t *old_screen = lv_screen_active();
+    trend_chart = NULL;
+    trend_series = NULL;
+    set_probe(1, NULL);
+    set_probe(2, NULL);
+    if (old_screen)
+    {
+        lv_obj_delete(old_screen);
+    }
+
+    uint32_t heap_before = ESP.getFreeHeap();
+    lv_obj_t *new_screen = screen == DISPLAY_SCREEN_OVERVIEW ? create_overview_screen() : create_detail_screen(tank);
+    lv_screen_load(new_screen);
+    screen_heap_bytes = heap_before - ESP.getFreeHeap(); // Approximate, other tasks allocate too
 }
 
-// Force screen refresh
-void force_screen_refresh()
+// Ask for a screen change - done after the current LVGL pass, as the request comes from an
+// event of a widget on the screen that is about to be deleted
+static void request_screen(display_screen_t screen, int tank)
 {
-    lv_obj_invalidate(lv_scr_act());
+    pending_screen = screen;
+    pending_tank = constrain(tank, 0, DISPLAY_TANK_COUNT - 1);
+    switch_requested_us = micros();
+}
+
+// Change to the requested screen and draw it, timing the switch from the tap
+static void switch_screen()
+{
+    show_screen(pending_screen, pending_tank);
+    pending_screen = DISPLAY_SCREEN_NONE;
+
     lv_refr_now(disp);
+    display_dma_wait();
+
+    screen_switch_us = micros() - switch_requested_us;
+    if (screen_switch_us > screen_switch_us_max)
+    {
+        screen_switch_us_max = screen_switch_us;
+    }
+
+    Serial.printf("Display: screen switch %lu us, screen uses %lu bytes, min free heap %lu bytes\n",
+                  (unsigned long)screen_switch_us, (unsigned long)screen_heap_bytes,
+                  (unsigned long)ESP.getMinFreeHeap());
+}
+
+// Create the UI - status bar and the first screen, further screens are built on demand
+void create_ui()
+{
+    // Status bar on the top layer stays while screens change beneath it
+    create_status_bar();
+    bind_view_model();
+    set_probe(0, status_bar);
+
+    // A single tank starts on its details, several on the overview
+    show_screen(DISPLAY_TANK_COUNT > 1 ? DISPLAY_SCREEN_OVERVIEW : DISPLAY_SCREEN_DETAIL, DISPLAY_LOCAL_TANK);
 }
 
-// Update display with current values
+// Read the probes back from the panel and redraw any region that no longer matches
+static void display_self_check()
+{
+    for (int i = 0; i < DISPLAY_PROBE_COUNT; i++)
+    {
+        display_probe_t *probe = &probes[i];
+        if (!probe->obj)
+        {
+            continue;
+        }
+
+        // Place the probe at the widget centre and have LVGL draw it once so the expected pixels are captured
+        if (!probe->placed)
+        {
+            lv_area_t coords;
+            lv_obj_get_coords(probe->obj, &coords);
+            probe->x = (coords.x1 + coords.x2 - DISPLAY_PROBE_SIZE) / 2;
+            probe->y = (coords.y1 + coords.y2 - DISPLAY_PROBE_SIZE) / 2;
+            probe->captured = 0;
+            probe->placed = true;
+            lv_obj_invalidate(probe->obj);
+            continue;
+        }
+
+        if (probe->captured != DISPLAY_PROBE_ALL)
+        {
+            continue;
+        }
+
+        bool match = true;
+        for (int bit = 0; bit < DISPLAY_PROBE_SIZE * DISPLAY_PROBE_SIZE && match; bit++)
+        {
+            uint16_t pixel = tft.readPixel(probe->x + bit % DISPLAY_PROBE_SIZE, probe->y + bit / DISPLAY_PROBE_SIZE);
+            match = (pixel == probe->expected[bit]);
+        }
+
+        if (!match)
+        {
+            Serial.printf("Display self-check: region at %ld,%ld corrupted, redrawing\n", (long)probe->x, (long)probe->y);
+            lv_obj_invalidate(probe->obj);
+            repair_count++;
+        }
+    }
+}
+
+// Time full-screen redraws and log the frame rate
+static void display_benchmark()
+{
+    if (DISPLAY_BENCHMARK_FRAMES <= 0)
+    {
+        return;
+    }
+
+    power_lock(POWER_LOCK_RENDER);
+    uint32_t wait_before = flush_wait_us;
+    unsigned long start = micros();
+    for (int i = 0; i < DISPLAY_BENCHMARK_FRAMES; i++)
+    {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(disp);
+        display_dma_wait();
+    }
+    unsigned long elapsed = micros() - start;
+    power_unlock(POWER_LOCK_RENDER);
+
+    benchmark_frame_us = elapsed / DISPLAY_BENCHMARK_FRAMES;
+    benchmark_wait_us = (flush_wait_us - wait_before) / DISPLAY_BENCHMARK_FRAMES;
+
+    Serial.printf("Display: full-screen redraw %lu us (%.1f fps), %lu us waiting for SPI, %s\n",
+                  (unsigned long)benchmark_frame_us, 1000000.0f / benchmark_frame_us,
+                  (unsigned long)benchmark_wait_us, dma_enabled ? "DMA" : "blocking");
+}
+
+// Update a tank's values - posts to the render task when something changed
+void update_tank(int tank, int height_mm, int level_percent, bool sensor_ok)
+{
+    static display_msg_t last[DISPLAY_TANK_COUNT];
+    static bool delivered[DISPLAY_TANK_COUNT] = {};
+
+    if (tank < 0 || tank >= DISPLAY_TANK_COUNT)
+    {
+        return;
+    }
+
+    if (delivered[tank] && height_mm == last[tank].height_mm && level_percent == last[tank].level_percent &&
+        sensor_ok == last[tank].sensor_ok)
+    {
+        return;
+    }
+
+    display_msg_t msg = {DISPLAY_MSG_VALUES};
+    msg.tank = tank;
+    msg.height_mm = height_mm;
+    msg.level_percent = level_percent;
+    msg.sensor_ok = sensor_ok;
+
+    if (display_post(&msg))
+    {
+        last[tank] = msg;
+        delivered[tank] = true;
+    }
+}
+
+// Update display with current values of this device's tank
 void update_display(int height_mm, int level_percent, bool wifi_connected, bool sensor_ok)
 {
-    static char height_text[20];
-    static char level_text[20];
+    update_tank(DISPLAY_LOCAL_TANK, height_mm, level_percent, sensor_ok);
+}
 
-    sprintf(height_text, "%d", height_mm);
-    sprintf(level_text, "%d", level_percent);
+// Run LVGL timers and rendering (render task), returns ms until LVGL needs to run again
+uint32_t display_loop()
+{
+    // Apply queued updates
+    display_msg_t msg;
+    while (display_queue && xQueueReceive(display_queue, &msg, 0) == pdTRUE)
+    {
+        uint32_t latency = micros() - msg.sent_us;
+        latency_us_sum += latency;
+        latency_count++;
+        if (latency > latency_us_max)
+        {
+            latency_us_max = latency;
+        }
+        display_apply(&msg);
+    }
+    update_uptime();
 
-    lv_label_set_text(height_label, height_text);
-    lv_label_set_text(level_label, level_text);
+    // Touch edge - read in this LVGL pass, then every read period until the release
+    if (touch_pending)
+    {
+        touch_pending = false;
+        lv_timer_t *read_timer = lv_indev_get_read_timer(touch_indev);
+        touch_first_read = true;
+        lv_timer_resume(read_timer);
+        lv_timer_ready(read_timer);
+    }
 
-    // Sensor status with color coding
-    if (sensor_ok)
+    power_lock(POWER_LOCK_RENDER);
+    uint32_t flushes_before = flush_count;
+    unsigned long start = micros();
+    uint32_t next = lv_timer_handler();
+
+    // Let the last stripe finish so the SPI bus is free and the CPU can slow down
+    display_dma_wait();
+    uint32_t elapsed = micros() - start;
+    render_us += elapsed;
+
+    // Frame time only counts passes that drew something
+    if (flush_count != flushes_before && elapsed > frame_us_max)
     {
-        lv_label_set_text(sensor_label, "Sensor: OK");
-        lv_obj_set_style_text_color(sensor_label, lv_color_hex(0x00FF00), 0);
+        frame_us_max = elapsed;
     }
-    else
+
+    // Screen change asked for by a tap during this pass
+    if (pending_screen != DISPLAY_SCREEN_NONE)
+    {
+        switch_screen();
+    }
+
+    // Optional readback check - repairs go through LVGL as normal dirty regions
+    static unsigned long last_self_check = 0;
+    unsigned long now = millis();
+    if (DISPLAY_SELF_CHECK_INTERVAL > 0 && now - last_self_check >= DISPLAY_SELF_CHECK_INTERVAL)
+    {
+        last_self_check = now;
+        display_self_check();
+    }
+    power_unlock(POWER_LOCK_RENDER);
+
+    // Roll the redraw statistics over once a second
+    if (now - stats_window_start >= 1000)
     {
-        lv_label_set_text(sensor_label, "Sensor: Error");
-        lv_obj_set_style_text_color(sensor_label, lv_color_hex(0xFF0000), 0);
+        portENTER_CRITICAL(&stats_mux);
+        last_stats.flushed_pixels_per_s = flushed_pixels;
+        last_stats.flushes_per_s = flush_count;
+        last_stats.render_us_per_s = render_us;
+        last_stats.flush_wait_us_per_s = flush_wait_us;
+        last_stats.frame_us_max = frame_us_max;
+        last_stats.queue_latency_us_avg = latency_count ? latency_us_sum / latency_count : 0;
+        last_stats.queue_latency_us_max = latency_us_max;
+        last_stats.repairs = repair_count;
+        last_stats.benchmark_frame_us = benchmark_frame_us;
+        last_stats.benchmark_wait_us = benchmark_wait_us;
+        last_stats.screen_switch_us = screen_switch_us;
+        last_stats.screen_switch_us_max = screen_switch_us_max;
+        last_stats.screen_heap_bytes = screen_heap_bytes;
+        last_stats.touch_reads_per_s = touch_reads;
+        last_stats.touch_read_us_avg = touch_reads ? touch_read_us_sum / touch_reads : 0;
+        last_stats.touch_read_us_max = touch_read_us_max;
+        last_stats.touch_wake_us = touch_wake_us;
+        last_stats.touch_spurious = touch_spurious;
+        portEXIT_CRITICAL(&stats_mux);
+
+        flushed_pixels = flush_count = render_us = flush_wait_us = 0;
+        frame_us_max = latency_us_sum = latency_us_max = latency_count = 0;
+        touch_reads = touch_read_us_sum = touch_read_us_max = 0;
+        stats_window_start = now;
     }
 
-    // Force screen update by invalidating the objects
-    lv_obj_invalidate(height_label);
-    lv_obj_invalidate(level_label);
-    lv_obj_invalidate(sensor_label);
-}
\ No newline at end of file
+    return next;
+}
+
+// Render task - owns LVGL, wakes when an update arrives or an LVGL timer is due
+static void display_task(void *param)
+{
+    task_monitor_register(MONITOR_TASK_DISPLAY, "display");
+
+    // Draws the UI for the first time
+    display_benchmark();
+
+    for (;;)
+    {
+        task_monitor_begin(MONITOR_TASK_DISPLAY);
+        uint32_t next = display_loop();
+        task_monitor_end(MONITOR_TASK_DISPLAY);
+        next = constrain(next, 1, DISPLAY_TASK_MAX_SLEEP);
+
+        display_msg_t msg;
+        xQueuePeek(display_queue, &msg, pdMS_TO_TICKS(next));
+    }
+}
+
+// Start the render task - LVGL must not be used from other tasks afterwards
+void display_start_task()
+{
+    if (display_task_handle)
+    {
+        return;
+    }
+
+    if (xTaskCreatePinnedToCore(display_task, "display", DISPLAY_TASK_STACK, NULL, DISPLAY_TASK_PRIORITY,
+                                &display_task_handle, DISPLAY_TASK_CORE) != pdPASS)
+    {
+        Serial.println("Failed to start display task");
+    }
+}
+
+// Get redraw statistics for the last second
+void get_display_stats(display_stats_t *stats)
+{
+    portENTER_CRITICAL(&stats_mux);
+    *stats = last_stats;
+    portEXIT_CRITICAL(&stats_mux);
+    stats->queue_dropped = queue_dropped.load(std::memory_order_relaxed);
+    stats->heap_min_free = ESP.getMinFreeHeap();
+}
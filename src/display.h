@@ -9,11 +9,62 @@
 extern const uint16_t screenWidth;
 extern const uint16_t screenHeight;
 
-// LVGL UI elements
-extern lv_obj_t *height_label;
-extern lv_obj_t *level_label;
-extern lv_obj_t *wifi_label;
-extern lv_obj_t *sensor_label;
+#define DISPLAY_BUFFER_LINES 40        // Lines per render buffer, two buffers of 240 x 40 x 2 bytes
+#define DISPLAY_BENCHMARK_FRAMES 5     // Full-screen redraws timed at startup, 0 = off
+#define DISPLAY_RSSI_INTERVAL 5000     // ms between signal strength updates
+#define DISPLAY_TASK_CORE 1            // Render task core - WiFi and lwIP run on core 0
+#define DISPLAY_TASK_PRIORITY 2        // Below the sensor task (3) on the same core, so UART ingest preempts rendering
+#define DISPLAY_TASK_STACK 8192        // Stack for LVGL rendering
+#define DISPLAY_TASK_MAX_SLEEP 100     // ms the render task sleeps at most without an update
+#define DISPLAY_QUEUE_LENGTH 8         // Pending display updates
+#define DISPLAY_NO_VALUE INT32_MIN     // Shown as "---" until the first reading
+#define DISPLAY_SELF_CHECK_INTERVAL 0  // ms between panel readback checks, 0 = off (needs TFT_MISO)
+#define DISPLAY_PROBE_SIZE 4           // Probe block edge in pixels (max 4, one bit per pixel)
+#define DISPLAY_TANK_COUNT 1           // Tanks on the overview screen
+#define DISPLAY_LOCAL_TANK 0           // Tank measured by this device's sensor (the others via update_tank())
+
+// XPT2046 touch controller - on the CYD it has its own SPI pins, not the display's 12/13/14
+#define TOUCH_CS_PIN 33                // T_CS
+#define TOUCH_CLK_PIN 25               // T_CLK
+#define TOUCH_MOSI_PIN 32              // T_DIN
+#define TOUCH_MISO_PIN 39              // T_DO
+#define TOUCH_IRQ_PIN 36               // T_IRQ (PENIRQ), low while the panel is touched
+#define TOUCH_SPI_FREQUENCY 2000000    // XPT2046 allows 2.5 MHz at most
+#define TOUCH_THRESHOLD 400            // Minimum pressure (Z1 + 4095 - Z2) for a touch
+
+// Raw-to-screen mapping for portrait mode. These are typical values for the CYD panel, not measured on
+// this unit: set TOUCH_LOG_RAW to 1, touch near each edge and copy the logged raw values here.
+#define TOUCH_SWAP_XY 1                // Screen x from the controller's Y channel (panel is mounted rotated)
+#define TOUCH_X_RAW_LEFT 3800          // Raw value at the left edge (may be larger than the right one)
+#define TOUCH_X_RAW_RIGHT 240
+#define TOUCH_Y_RAW_TOP 200
+#define TOUCH_Y_RAW_BOTTOM 3700
+#define TOUCH_LOG_RAW 0                // Log raw x/y/z of every read on the serial port
+
+// Redraw statistics for the last second
+struct display_stats_t
+{
+    uint32_t flushed_pixels_per_s;
+    uint32_t flushes_per_s;
+    uint32_t render_us_per_s;      // Time spent in LVGL timers, rendering and flushing
+    uint32_t flush_wait_us_per_s;  // Time the CPU waited for SPI transfers to finish
+    uint32_t frame_us_max;         // Longest LVGL pass that drew something
+    uint32_t queue_latency_us_avg; // Time from update_display()/update_status_bar() to the render task
+    uint32_t queue_latency_us_max;
+    uint32_t queue_dropped;        // Updates lost to a full queue since boot (resent on the next change)
+    uint32_t repairs;              // Regions redrawn by the self-check since boot
+    uint32_t benchmark_frame_us;   // Full-screen redraw time measured at startup
+    uint32_t benchmark_wait_us;    // Of which waiting for SPI transfers
+    uint32_t screen_switch_us;     // Last screen change, from the tap until the new screen is on the panel
+    uint32_t screen_switch_us_max; // Since boot
+    uint32_t screen_heap_bytes;    // Heap taken by the screen being shown
+    uint32_t heap_min_free;        // Lowest free heap since boot (high-water mark of heap use)
+    uint32_t touch_reads_per_s;    // Touch controller reads - only while the panel is touched
+    uint32_t touch_read_us_avg;    // Per read of the controller
+    uint32_t touch_read_us_max;
+    uint32_t touch_wake_us;        // Last PENIRQ edge to the first read
+    uint32_t touch_spurious;       // Wakes that found no touch, since boot
+};
 
 // Status bar elements
 extern lv_obj_t *status_bar;
@@ -29,12 +80,17 @@ void lvgl_init();
 void create_status_bar();
 void create_ui();
 void update_display(int height_mm, int level_percent, bool wifi_connected, bool sensor_ok);
+void update_tank(int tank, int height_mm, int level_percent, bool sensor_ok);
 void update_status_bar(bool wifi_connected, bool sensor_ok, bool mqtt_connected);
 void update_uptime();
-void force_screen_refresh();
+void display_add_trend_point(int16_t point, uint32_t seq);
+uint32_t display_loop();
+void display_start_task();
+void get_display_stats(display_stats_t *stats);
 
 // LVGL callback functions
 void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *color_p);
+void my_disp_flush_wait(lv_display_t *disp);
 void my_touchpad_read(lv_indev_t *indev_driver, lv_indev_data_t *data);
 
 #endif // DISPLAY_H
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "duty_cycle.h"
+#include <esp_sleep.h>
+#include "sensor.h"
+#include "wifi_manager.h"
+#include "nmea.h"
+#include "mqtt.h"
+
+// State kept in RTC memory across deep sleep
+RTC_DATA_ATTR static uint32_t wake_count = 0;
+RTC_DATA_ATTR static uint32_t device_time_ms = 0; // Time since first boot at the start of this wake
+RTC_DATA_ATTR static mqtt_sample_t pending_samples[DUTY_CYCLE_PENDING_SAMPLES];
+RTC_DATA_ATTR static uint8_t pending_count = 0;
+
+// Keep a sample for the next batch, dropping the oldest when full
+static void duty_cycle_store_sample(int height_mm, int level_percent)
+{
+    if (pending_count == DUTY_CYCLE_PENDING_SAMPLES)
+    {
+        memmove(pending_samples, pending_samples + 1, sizeof(pending_samples[0]) * (DUTY_CYCLE_PENDING_SAMPLES - 1));
+        pending_count--;
+    }
+
+    mqtt_sample_t &sample = pending_samples[pending_count++];
+    sample.timestamp = device_time_ms + millis(); // Monotonic across wakes, unlike millis()
+    sample.height_mm = height_mm;
+    sample.level_percent = level_percent;
+}
+
+// Wait for a condition while running a loop handler, returns false on timeout
+static bool duty_cycle_wait(bool (*done)(), void (*handler)(), unsigned long timeout_ms)
+{
+    unsigned long start = millis();
+    while (!done())
+    {
+        if (millis() - start >= timeout_ms)
+        {
+            return false;
+        }
+        handler();
+        delay(10);
+    }
+    return true;
+}
+
+// WiFi is up and wifi_loop() has handled the connection, which also saves the BSSID/channel cache
+static bool duty_cycle_wifi_ready()
+{
+    return get_wifi_state() == WIFI_STATE_CONNECTED;
+}
+
+// Power down everything and sleep until the next measurement
+static void duty_cycle_sleep()
+{
+    sensor_power_off();
+
+    Serial.print("Awake ");
+    Serial.print(millis());
+    Serial.println(" ms, sleeping");
+    Serial.flush();
+
+    device_time_ms += millis() + DUTY_CYCLE_SLEEP_S * 1000UL;
+
+    esp_sleep_enable_timer_wakeup((uint64_t)DUTY_CYCLE_SLEEP_S * 1000000ULL);
+    esp_deep_sleep_start();
+}
+
+// Run one measure/report cycle and deep-sleep - does not return
+void duty_cycle_run()
+{
+    wake_count++;
+    Serial.print("Duty cycle wake ");
+    Serial.println(wake_count);
+
+#ifdef TFT_BL
+    // Display is not used in this mode - keep the backlight off
+    pinMode(TFT_BL, OUTPUT);
+    digitalWrite(TFT_BL, LOW);
+#endif
+
+    // Power the sensor and collect a burst into the RTC-backed filter
+    sensor_init();
+    int frames = read_sensor_burst(DUTY_CYCLE_BURST_FRAMES, DUTY_CYCLE_BURST_TIMEOUT);
+    bool sensor_ok = frames > 0;
+    sensor_power_off();
+
+    int height_mm = get_filtered_height();
+    int level_percent = calculate_level(height_mm);
+    String level_string(level_percent);
+
+    if (sensor_ok)
+    {
+        duty_cycle_store_sample(height_mm, level_percent);
+    }
+    else
+    {
+        Serial.println("No sensor frames this wake");
+    }
+
+    // Serial output works without any network
+    String nmea_data = create_nmea_xdr(level_string);
+    send_nmea_serial(nmea_data);
+
+    // Join WiFi - the cached BSSID/channel from RTC memory avoids a scan
+    wifi_init();
+    wifi_start();
+    if (!duty_cycle_wait(duty_cycle_wifi_ready, wifi_loop, DUTY_CYCLE_WIFI_TIMEOUT))
+    {
+        Serial.println("WiFi not reached, samples kept for the next wake");
+        duty_cycle_sleep();
+    }
+
+    if (sensor_ok)
+    {
+        nmea_init();
+        send_nmea_data(nmea_data);
+    }
+
+    // One batched MQTT message with every sample not yet delivered
+    mqtt_init();
+    if (pending_count > 0 && duty_cycle_wait(is_mqtt_connected, mqtt_loop, DUTY_CYCLE_MQTT_TIMEOUT))
+    {
+        if (mqtt_publish_samples(pending_samples, pending_count, true, sensor_ok))
+        {
+            pending_count = 0;
+        }
+        mqtt_disconnect();
+    }
+
+    duty_cycle_sleep();
+}
+
+// Get number of wakes since power-on
+uint32_t get_duty_cycle_wake_count()
+{
+    return wake_count;
+}
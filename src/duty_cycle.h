@@ -0,0 +1,28 @@
+/*
+ * Duty-Cycled Mode for NMEA0183 Level Sensor
+ *
+ * Battery mode for unattended tanks: wake on a timer, power the sensor,
+ * collect a burst of frames, send one XDR sentence and one batched MQTT
+ * message, then deep-sleep. Filter state, sequence counters, unsent
+ * samples and the WiFi cache live in RTC memory so each wake starts warm.
+ */
+
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <Arduino.h>
+
+// Duty cycle configuration
+#define DUTY_CYCLE_ENABLED 0           // 1 = measure, report and deep-sleep instead of running the UI
+#define DUTY_CYCLE_SLEEP_S 900         // Deep sleep between measurements (15 minutes)
+#define DUTY_CYCLE_BURST_FRAMES 3      // Valid sensor frames collected per wake
+#define DUTY_CYCLE_BURST_TIMEOUT 6000  // Give up on the sensor after this long (it sends every 1-2 s)
+#define DUTY_CYCLE_WIFI_TIMEOUT 5000   // Time allowed to join WiFi (cached AP makes this ~1 s)
+#define DUTY_CYCLE_MQTT_TIMEOUT 4000   // Time allowed to reach the broker
+#define DUTY_CYCLE_PENDING_SAMPLES 16  // Unsent samples kept in RTC memory across wakes
+
+// Function declarations
+void duty_cycle_run();
+uint32_t get_duty_cycle_wake_count();
+
+#endif // DUTY_CYCLE_H
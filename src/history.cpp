@@ -0,0 +1,76 @@
+#include "history.h"
+
+// Closed buckets, oldest first from history_next - guarded for readers in other tasks
+static int16_t history_points[HISTORY_POINTS];
+static int history_count = 0;
+static int history_next = 0;
+static uint32_t history_seq = 0; // Sequence number of the newest point, 0 = none yet
+static portMUX_TYPE history_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Bucket being filled (sensor task only)
+static unsigned long bucket_start = 0;
+static long bucket_sum = 0;
+static uint32_t bucket_samples = 0;
+static uint32_t last_sample = 0;
+
+// Store a closed bucket - returns its sequence number
+static uint32_t history_store(int16_t point)
+{
+    portENTER_CRITICAL(&history_mux);
+    uint32_t seq = ++history_seq;
+    history_points[history_next] = point;
+    history_next = (history_next + 1) % HISTORY_POINTS;
+    if (history_count < HISTORY_POINTS)
+    {
+        history_count++;
+    }
+    portEXIT_CRITICAL(&history_mux);
+
+    return seq;
+}
+
+// Add the latest sample to the current bucket - returns true, the point and its sequence number when a
+// bucket closed. Closes at most one bucket per call, so a long gap is caught up over the following calls.
+bool history_update(const sensor_snapshot_t *snapshot, int16_t *point, uint32_t *seq)
+{
+    unsigned long now = millis();
+
+    if (snapshot->sample != last_sample)
+    {
+        last_sample = snapshot->sample;
+        if (snapshot->sensor_ok)
+        {
+            bucket_sum += snapshot->level_percent;
+            bucket_samples++;
+        }
+    }
+
+    if (now - bucket_start < (unsigned long)HISTORY_BUCKET_S * 1000)
+    {
+        return false;
+    }
+
+    *point = bucket_samples ? (int16_t)((bucket_sum + (long)bucket_samples / 2) / (long)bucket_samples) : HISTORY_NO_VALUE;
+    bucket_start += (unsigned long)HISTORY_BUCKET_S * 1000;
+    bucket_sum = 0;
+    bucket_samples = 0;
+
+    *seq = history_store(*point);
+    return true;
+}
+
+// Copy the stored points, oldest first - returns the number copied and the sequence number of the last one
+int history_get_points(int16_t *points, int max_points, uint32_t *last_seq)
+{
+    portENTER_CRITICAL(&history_mux);
+    *last_seq = history_seq;
+    int count = min(history_count, max_points);
+    int first = (history_next - count + HISTORY_POINTS) % HISTORY_POINTS;
+    for (int i = 0; i < count; i++)
+    {
+        points[i] = history_points[(first + i) % HISTORY_POINTS];
+    }
+    portEXIT_CRITICAL(&history_mux);
+
+    return count;
+}
@@ -0,0 +1,27 @@
+/*
+ * History Module for NMEA0183 Level Sensor
+ *
+ * Downsampled level history for the trend chart. Samples are averaged
+ * into fixed time buckets; each closed bucket becomes one chart point.
+ * Points are kept in a ring so the chart can be filled again when it is
+ * created, and are otherwise appended one at a time. Every point has a
+ * sequence number so a point that is both in the replayed history and
+ * still on its way to the chart is only added once.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "sensor.h"
+
+// History configuration
+#define HISTORY_POINTS 180         // Chart points (about one per pixel column)
+#define HISTORY_BUCKET_S 480       // Seconds per point - 180 x 8 min = 24 h
+#define HISTORY_NO_VALUE INT16_MIN // Bucket without a valid sample (gap in the chart)
+
+// Function declarations
+bool history_update(const sensor_snapshot_t *snapshot, int16_t *point, uint32_t *seq);
+int history_get_points(int16_t *points, int max_points, uint32_t *last_seq);
+
+#endif // HISTORY_H
@@ -0,0 +1,164 @@
+#include "json_writer.h"
+
+JsonWriter::JsonWriter(char *buffer, size_t size)
+    : buffer(buffer), size(size), len(0), overflow(false), depth(0), has_items(0)
+{
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+}
+
+// Append raw bytes, keeping the buffer NUL-terminated - nothing more is written after an overflow
+void JsonWriter::append(const char *text, size_t count)
+{
+    if (overflow || len + count >= size)
+    {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + len, text, count);
+    len += count;
+    buffer[len] = '\0';
+}
+
+void JsonWriter::appendChar(char c)
+{
+    append(&c, 1);
+}
+
+// Format an unsigned integer without printf
+void JsonWriter::appendUnsigned(unsigned long value)
+{
+    char digits[20]; // 2^64 - 1 has 20 digits (unsigned long is 64-bit on LP64 hosts)
+    int pos = sizeof(digits);
+    do
+    {
+        digits[--pos] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    append(digits + pos, sizeof(digits) - pos);
+}
+
+// Write separator and key (if any) before a value
+void JsonWriter::beginValue(const char *key)
+{
+    uint8_t level_bit = 1 << depth;
+    if (has_items & level_bit)
+    {
+        appendChar(',');
+    }
+    has_items |= level_bit;
+
+    if (key != NULL)
+    {
+        appendChar('"');
+        append(key, strlen(key));
+        append("\":", 2);
+    }
+}
+
+void JsonWriter::beginObject(const char *key)
+{
+    // Too deep to track separators - fail like a full buffer instead of writing broken JSON
+    if (depth >= JSON_WRITER_MAX_DEPTH - 1)
+    {
+        overflow = true;
+        return;
+    }
+
+    beginValue(key);
+    appendChar('{');
+    depth++;
+    has_items &= ~(1 << depth);
+}
+
+void JsonWriter::endObject()
+{
+    if (depth > 0)
+    {
+        depth--;
+    }
+    appendChar('}');
+}
+
+void JsonWriter::beginArray(const char *key)
+{
+    // Too deep to track separators - fail like a full buffer instead of writing broken JSON
+    if (depth >= JSON_WRITER_MAX_DEPTH - 1)
+    {
+        overflow = true;
+        return;
+    }
+
+    beginValue(key);
+    appendChar('[');
+    depth++;
+    has_items &= ~(1 << depth);
+}
+
+void JsonWriter::endArray()
+{
+    if (depth > 0)
+    {
+        depth--;
+    }
+    appendChar(']');
+}
+
+void JsonWriter::addInt(const char *key, long value)
+{
+    beginValue(key);
+    if (value < 0)
+    {
+        appendChar('-');
+        appendUnsigned(0UL - (unsigned long)value);
+    }
+    else
+    {
+        appendUnsigned(value);
+    }
+}
+
+void JsonWriter::addUInt(const char *key, unsigned long value)
+{
+    beginValue(key);
+    appendUnsigned(value);
+}
+
+void JsonWriter::addBool(const char *key, bool value)
+{
+    beginValue(key);
+    if (value)
+    {
+        append("true", 4);
+    }
+    else
+    {
+        append("false", 5);
+    }
+}
+
+// Add a string value, escaping quotes, backslashes and control characters
+void JsonWriter::addString(const char *key, const char *value)
+{
+    beginValue(key);
+    appendChar('"');
+    for (const char *p = value; *p != '\0'; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            appendChar('\\');
+            appendChar(*p);
+        }
+        else if ((unsigned char)*p < 0x20)
+        {
+            appendChar(' ');
+        }
+        else
+        {
+            appendChar(*p);
+        }
+    }
+    appendChar('"');
+}
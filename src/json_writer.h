@@ -0,0 +1,51 @@
+/*
+ * JSON Writer
+ *
+ * Minimal streaming JSON serializer that writes into a caller-supplied
+ * fixed buffer. Used to build MQTT payloads without String concatenation
+ * so publishing never touches the heap.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define JSON_WRITER_MAX_DEPTH 8 // Maximum nesting of objects/arrays
+
+class JsonWriter
+{
+public:
+    JsonWriter(char *buffer, size_t size); // Writes into buffer, always NUL-terminated
+
+    void beginObject(const char *key = NULL); // Key is only used inside an object
+    void endObject();
+    void beginArray(const char *key = NULL);
+    void endArray();
+
+    void addInt(const char *key, long value);
+    void addUInt(const char *key, unsigned long value);
+    void addBool(const char *key, bool value);
+    void addString(const char *key, const char *value);
+
+    const char *c_str() const { return buffer; }
+    size_t length() const { return len; }
+    bool overflowed() const { return overflow; } // True if the buffer was too small or nesting too deep
+
+private:
+    void beginValue(const char *key);
+    void append(const char *text, size_t count);
+    void appendChar(char c);
+    void appendUnsigned(unsigned long value);
+
+    char *buffer;
+    size_t size;
+    size_t len;
+    bool overflow;
+    uint8_t depth;
+    uint8_t has_items; // Bit per nesting level: a value was already written
+};
+
+#endif // JSON_WRITER_H
@@ -105,6 +105,8 @@
  * - LV_OS_RTTHREAD
  * - LV_OS_WINDOWS
  * - LV_OS_CUSTOM */
+/*NONE: only the display task calls LVGL, and any other setting makes the SW renderer draw in an
+ *extra, unpinned LVGL thread instead of the display task pinned to core 1*/
 #define LV_USE_OS   LV_OS_NONE
 
 #if LV_USE_OS == LV_OS_CUSTOM
@@ -1,39 +1,8 @@
 /*
-     // Initialize WiFi system
-    wifi_init();
-    bool wifi_is_connected = wifi_connect();
-
-    // Initialize NMEA/UDP system
-    nmea_init();
-
-    // Initialize MQTT system
-    mqtt_init();
-    if (wifi_is_connected)  // Only try MQTT if WiFi is connected
-    {
-        mqtt_connect();
-    }
-
-    Serial.println("=== System Ready ===");ensor for ESP32 CYD
+ * NMEA0183 Level Sensor for ESP32 CYD
  *
  * Description:
- *     // Initialize WiFi system
-    wifi_init();
-    if (wifi_connect())
-    {
-        // WiFi connected successfully
-    }
-
-    // Initialize NMEA/UDP system
-    nmea_init();
-
-    // Initialize MQTT system
-    mqtt_init();
-    if (wifi_connect())  // Only try MQTT if WiFi is connected
-    {
-        mqtt_connect();
-    }
-
-    Serial.println("=== System Ready ===");c level sensor with NMEA0183 output for marine applications.
+ *   Ultrasonic level sensor with NMEA0183 output for marine applications.
  *   Supports ESP32 CYD (Cheap Yellow Display) with LVGL GUI and WiFi connectivity.
  *   Broadcasts sensor data via UDP in NMEA XDR format for integration with
  *   OpenCPN and other marine electronics.
@@ -74,99 +43,269 @@
 #endif
 
 // Include our modular components
+#include "config.h"
+#include "duty_cycle.h"
+#include "power.h"
 #include "display.h"
 #include "sensor.h"
 #include "wifi_manager.h"
 #include "nmea.h"
 #include "mqtt.h"
+#include "signalk.h"
+#include "n2k.h"
+#include "scheduler.h"
+#include "task_monitor.h"
+#include "history.h"
 
-void setup()
+// Network-side copy of the latest sample - only used by the network task
+static sensor_snapshot_t sample = {};
+static String level_string = "0";
+static uint32_t last_sample = 0;
+static bool network_pending = false;
+static bool status_pending = false;
+
+// Tasks whose period follows the runtime configuration
+static int sample_task_id = -1;
+static int status_task_id = -1;
+
+// Sensor task - UART ingest and filtering, results are handed over as snapshots
+static void sensor_task(void *parameter)
 {
-    Serial.begin(115200);
-    Serial.println("=== NMEA Level Sensor Starting ===");
+    task_monitor_register(MONITOR_TASK_SENSOR, "sensor");
+    TickType_t last_wake = xTaskGetTickCount();
 
-    // Initialize display system
-    display_init();
-    lvgl_init();
-    create_ui();
+    for (;;)
+    {
+        task_monitor_begin(MONITOR_TASK_SENSOR);
+        sensor_poll();
 
-    // Initialize sensor system
-    sensor_init();
+        // The display gets changes through its queue
+        sensor_snapshot_t snapshot;
+        get_sensor_snapshot(&snapshot);
+        if (snapshot.sample > 0)
+        {
+            update_display(snapshot.height_mm, snapshot.level_percent, is_wifi_connected(), snapshot.sensor_ok);
+        }
 
-    // Initialize WiFi system
-    wifi_init();
-    if (wifi_connect())
+        // Downsampled history - one chart point per closed bucket
+        int16_t point;
+        uint32_t seq;
+        if (history_update(&snapshot, &point, &seq))
+        {
+            display_add_trend_point(point, seq);
+        }
+        task_monitor_end(MONITOR_TASK_SENSOR);
+
+        // Fixed period without drift
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(get_runtime_config().loop_ms));
+    }
+}
+
+// Pick up a new sample from the sensor task, start with the outputs that need no network
+static void sample_task()
+{
+    sensor_snapshot_t latest;
+    get_sensor_snapshot(&latest);
+    if (latest.sample == last_sample)
     {
-        // WiFi connected successfully
+        return;
     }
 
-    // Initialize NMEA/UDP system
-    nmea_init();
+    // The previous sample has not been sent yet (e.g. waiting for a TX window) - the network outputs only
+    // carry the latest value, so MQTT keeps this one in its queue instead of losing it
+    if (network_pending && mqtt_publish_due(sample.height_mm))
+    {
+        mqtt_defer_sample(sample.height_mm, sample.level_percent, sample.timestamp_ms);
+    }
 
-    Serial.println("=== System Ready ===");
+    sample = latest;
+    last_sample = sample.sample;
+    level_string = String(sample.level_percent);
+
+    // NMEA 2000 and serial output work without any network
+    n2k_send_fluid_level(sample.level_percent);
+    send_nmea_serial(create_nmea_xdr(level_string));
+    network_pending = true;
 }
-void loop()
+
+// Send the latest sample on the network outputs
+static void publish_sample(bool wifi_connected)
 {
-    static int loop_count = 0;
-    loop_count++;
+    if (wifi_connected)
+    {
+        String nmea_data = create_nmea_xdr(level_string);
+        send_nmea_data(nmea_data);
 
-    // Handle LVGL display tasks - this needs to be called regularly
-    lv_timer_handler();
+        // Push Signal K delta to subscribed WebSocket clients
+        signalk_publish_tank_data(sample.height_mm, level_string);
 
-    // Handle MQTT tasks - this needs to be called regularly
-    mqtt_loop();
+        // Also send NMEA data via MQTT if connected
+        if (is_mqtt_connected())
+        {
+            mqtt_publish_nmea_data(nmea_data);
+        }
+    }
 
-    // Read sensor data
-    int height_mm = read_sensor();
-    calculate_level(height_mm);
+    // Publish sensor data via MQTT - queued for later replay while the broker is unreachable
+    if (mqtt_publish_due(sample.height_mm))
+    {
+        mqtt_publish_sensor_data(sample.height_mm, level_string);
+        mqtt_publish_binary_data(sample.height_mm, level_string, wifi_connected, sample.sensor_ok);
+    }
+}
 
-    // Get system status
-    bool sensor_ok = is_sensor_ok();
+// Network outputs - in power-save mode the latest values, the status and the MQTT backlog go out together
+// in one short TX window
+static void publish_task()
+{
     bool wifi_connected = is_wifi_connected();
-    bool mqtt_connected = is_mqtt_connected();
+    if ((!network_pending && !status_pending) || (wifi_connected && !wifi_tx_window_due()))
+    {
+        return;
+    }
 
-    // Update status bar
-    update_status_bar(wifi_connected, sensor_ok, mqtt_connected);
+    unsigned long tx_start = millis();
+    power_lock(POWER_LOCK_NETWORK);
 
-    // Check WiFi connection and reset if lost
-    wifi_reset_if_lost();
+    if (network_pending)
+    {
+        publish_sample(wifi_connected);
+        network_pending = false;
+    }
+
+    if (status_pending && is_mqtt_connected())
+    {
+        mqtt_publish_status_data(wifi_connected, sample.sensor_ok);
+        mqtt_publish_json_data(sample.height_mm, level_string, wifi_connected, sample.sensor_ok);
+    }
+    status_pending = false;
+
+    if (WIFI_POWER_SAVE && wifi_connected)
+    {
+        mqtt_send_pending();
+    }
+
+    power_unlock(POWER_LOCK_NETWORK);
+    if (wifi_connected)
+    {
+        wifi_tx_window_done(millis() - tx_start);
+    }
+}
+
+// MQTT and Signal K client housekeeping
+static void mqtt_task()
+{
+    mqtt_loop();
+    signalk_loop();
+}
 
-    // Update main display - use the level from calculate_level instead of recalculating
-    String level_string = get_level_percent();
-    int level_percent = level_string.toInt();
+// NMEA 2000 address claiming and periodic output
+static void n2k_task()
+{
+    n2k_loop();
+}
 
-    update_display(height_mm, level_percent, wifi_connected, sensor_ok);
+// Reconnect WiFi in the background if the connection was lost, and show the connection state
+static void wifi_task()
+{
+    wifi_loop();
+    update_status_bar(is_wifi_connected(), sample.sensor_ok, is_mqtt_connected());
+}
 
-    // Force screen refresh every 20 loops (about once per second)
-    if (loop_count % 20 == 0)
+// Periodic status updates via MQTT - sent by publish_task() so they share its TX window
+static void status_task()
+{
+    if (is_mqtt_connected())
     {
-        force_screen_refresh();
+        status_pending = true;
     }
+}
+
+// Network task - all network outputs and connection supervision, next to the WiFi stack
+static void network_task(void *parameter)
+{
+    task_monitor_register(MONITOR_TASK_NETWORK, "network");
 
-    // Send NMEA data if WiFi is connected and new sensor data is available
-    if (wifi_connected && is_new_data_available())
+    for (;;)
     {
-        String nmea_data = create_nmea_xdr(level_string);
-        send_nmea_data(nmea_data);
+        // Pick up period changes from the command topic
+        runtime_config_t config = get_runtime_config();
+        scheduler_set_period(sample_task_id, config.loop_ms);
+        scheduler_set_period(status_task_id, config.status_ms);
 
-        // Also send data via MQTT if connected
-        if (mqtt_connected)
-        {
-            mqtt_publish_sensor_data(height_mm, level_string);
-            mqtt_publish_nmea_data(nmea_data);
-        }
+        // Run whatever is due, then sleep until the next release
+        task_monitor_begin(MONITOR_TASK_NETWORK);
+        uint32_t sleep_ms = scheduler_run();
+        task_monitor_end(MONITOR_TASK_NETWORK);
+
+        vTaskDelay(pdMS_TO_TICKS(sleep_ms));
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    Serial.println("=== NMEA Level Sensor Starting ===");
+
+    // Load runtime configuration defaults - updated later over MQTT
+    config_init();
+
+    // Drop to the minimum CPU frequency between work items
+    power_init();
+
+    // Battery mode - measure, report and deep-sleep without starting the UI (does not return)
+    if (DUTY_CYCLE_ENABLED)
+    {
+        duty_cycle_run();
     }
 
-    // Send periodic status updates via MQTT (every 100 loops = ~5 seconds)
-    if (mqtt_connected && loop_count % 100 == 0)
+    // Initialize display system
+    display_init();
+    lvgl_init();
+    create_ui();
+
+    // Initialize sensor system
+    sensor_init();
+
+    // Render task draws the UI and keeps it updated independently of loop() and the network
+    display_start_task();
+
+    // Initialize WiFi system - connects in the background, local outputs never wait for it
+    wifi_init();
+    wifi_start();
+
+    // Initialize NMEA/UDP system
+    nmea_init();
+
+    // Initialize MQTT system - connection is handled by mqtt_loop()
+    mqtt_init();
+
+    // Initialize Signal K WebSocket server
+    signalk_init();
+
+    // Initialize NMEA 2000 output (independent of WiFi)
+    if (!n2k_init())
     {
-        mqtt_publish_status_data(wifi_connected, sensor_ok);
-        mqtt_publish_json_data(height_mm, level_string, wifi_connected, sensor_ok);
+        Serial.println("NMEA 2000 initialization failed");
     }
 
-    // Flash LED to indicate activity
-    // Note: LED control is handled in wifi_manager.cpp
+    // Network work, highest priority (0) first when several tasks are due
+    runtime_config_t config = get_runtime_config();
+    sample_task_id = scheduler_add("sample", sample_task, config.loop_ms, SCHEDULER_SAMPLE_DEADLINE, 0);
+    scheduler_add("mqtt", mqtt_task, SCHEDULER_MQTT_PERIOD, SCHEDULER_MQTT_PERIOD, 1);
+    scheduler_add("n2k", n2k_task, SCHEDULER_N2K_PERIOD, SCHEDULER_N2K_PERIOD, 1);
+    scheduler_add("publish", publish_task, SCHEDULER_PUBLISH_PERIOD, SCHEDULER_PUBLISH_PERIOD, 2);
+    scheduler_add("wifi", wifi_task, SCHEDULER_WIFI_PERIOD, SCHEDULER_WIFI_PERIOD, 3);
+    status_task_id = scheduler_add("status", status_task, config.status_ms, SCHEDULER_STATUS_DEADLINE, 4);
 
-    // Small delay to give LVGL time to process and prevent overwhelming the system
-    delay(50); // 50ms delay = 20 FPS update rate
-}
\ No newline at end of file
+    // Sensor next to the render task on core 1, network on core 0 with the WiFi stack
+    xTaskCreatePinnedToCore(sensor_task, "sensor", SENSOR_TASK_STACK, NULL, SENSOR_TASK_PRIORITY, NULL, SENSOR_TASK_CORE);
+    xTaskCreatePinnedToCore(network_task, "network", NETWORK_TASK_STACK, NULL, NETWORK_TASK_PRIORITY, NULL, NETWORK_TASK_CORE);
+
+    Serial.println("=== System Ready ===");
+}
+void loop()
+{
+    // All work runs in the sensor, network and display tasks
+    vTaskDelete(NULL);
+}
@@ -1,28 +1,144 @@
 #include "mqtt.h"
-
-// WiFi and MQTT client instances
-WiFiClient wifiClient;
-PubSubClient mqttClient(wifiClient);
+#include "json_writer.h"
+#include "cbor_writer.h"
+#include "config.h"
+#include "wifi_manager.h"
+#include "nmea.h"
+#include "power.h"
+#include "display.h"
+#include "scheduler.h"
+#include "task_monitor.h"
+#include "sensor.h"
+#include "duty_cycle.h"
+#if MQTT_USE_V5
+#include "mqtt5_client.h"
+#endif
+#if MQTT_USE_TLS
+#include "tls_client.h"
+#include "mqtt_ca_cert.h"
+#endif
+
+// Network and MQTT client instances
+#if MQTT_USE_TLS
+TlsClient netClient;
+#else
+WiFiClient netClient;
+#endif
+#if MQTT_USE_V5
+Mqtt5Client mqttClient(netClient);
+#else
+PubSubClient mqttClient(netClient);
+#endif
 
 // Connection state tracking
 bool mqtt_initialized = false;
-unsigned long last_reconnect_attempt = 0;
-int connection_retries = 0;
+static volatile mqtt_state_t mqtt_state = MQTT_STATE_DISCONNECTED;
+static unsigned long next_connect_attempt = 0;
+static unsigned long backoff_delay = MQTT_BACKOFF_MIN;
+
+// Batch of samples waiting to be published
+static mqtt_sample_t batch_samples[MQTT_BATCH_MAX_SAMPLES];
+static uint8_t batch_count = 0;
+static unsigned long batch_start = 0;
+static bool batch_wifi_connected = false;
+static bool batch_sensor_ok = false;
+RTC_DATA_ATTR static uint32_t batch_sequence = 0; // Survives deep sleep
+
+// Last published sample for the deadband and publish interval
+static int last_published_height = 0;
+static unsigned long last_published_time = 0;
+static bool published_once = false;
+
+// Background connect task - PubSubClient::connect() blocks for TCP connect and CONNACK
+static TaskHandle_t connect_task = NULL;
+static volatile int8_t connect_result = 0; // 0 = pending, 1 = connected, -1 = failed
+
+// Run blocking connection attempts outside loop()
+static void mqtt_connect_task(void *parameter)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        connect_result = mqtt_connect() ? 1 : -1;
+    }
+}
+
+// Publish the active runtime configuration (retained, doubles as command acknowledgement)
+static void mqtt_publish_config()
+{
+    char payload[MQTT_JSON_BUFFER_SIZE];
+    size_t length = config_to_json(payload, sizeof(payload));
+    if (length > 0)
+    {
+        mqttClient.publish(MQTT_TOPIC_CONFIG, (const uint8_t *)payload, length, true);
+    }
+}
+
+// Handle messages on subscribed topics - runs inside mqttClient.loop()
+static void mqtt_message_callback(char *topic, uint8_t *payload, unsigned int length)
+{
+    if (strcmp(topic, MQTT_TOPIC_COMMAND) != 0)
+    {
+        return;
+    }
+
+    if (config_apply_json((const char *)payload, length))
+    {
+        mqtt_publish_config();
+    }
+}
 
 // Initialize MQTT system
 void mqtt_init()
 {
     // Configure MQTT broker
+#if MQTT_USE_TLS
+    netClient.setCACert(mqtt_ca_cert);
+    if (mqtt_ca_cert[0] == '\0')
+    {
+#if MQTT_TLS_INSECURE
+        netClient.setInsecure();
+        Serial.println("MQTT: WARNING - no CA certificate, the broker is not verified (MQTT_TLS_INSECURE)");
+#else
+        Serial.println("MQTT: no CA certificate in mqtt_ca_cert.h - TLS connections will be refused");
+#endif
+    }
+    netClient.setServerName(MQTT_TLS_SERVER_NAME);
+    netClient.setSessionPersistence(MQTT_TLS_SESSION_NVS);
+    mqttClient.setServer(MQTT_BROKER_IP, MQTT_TLS_PORT);
+#else
     mqttClient.setServer(MQTT_BROKER_IP, MQTT_BROKER_PORT);
+#endif
 
     // Set keep alive and socket timeout for better reliability
     mqttClient.setKeepAlive(60); // 60 seconds keep alive
+    mqttClient.setSocketTimeout(MQTT_CONNACK_TIMEOUT);
+
+#if MQTT_USE_V5
+    mqttClient.setMessageExpiry(MQTT5_MESSAGE_EXPIRY);
+#endif
+
+    // Large enough that a whole batch is assembled and written in one TCP segment
+    mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+
+    // Runtime configuration commands
+    mqttClient.setCallback(mqtt_message_callback);
+
+    // Connection attempts run in their own task so loop() never waits on the broker
+    xTaskCreatePinnedToCore(mqtt_connect_task, "mqtt_connect", MQTT_CONNECT_TASK_STACK, NULL, 1, &connect_task, 0);
+
+    // Offline queue for samples taken while the broker is unreachable. In duty-cycled mode unsent samples
+    // stay in RTC memory, and mounting flash (and dropping the spill file) on every wake would only cost time.
+    if (!DUTY_CYCLE_ENABLED)
+    {
+        mqtt_queue_init();
+    }
 
     mqtt_initialized = true;
     Serial.println("MQTT system initialized");
 }
 
-// Connect to MQTT broker
+// Connect to MQTT broker (blocking - normally runs in the connect task)
 bool mqtt_connect()
 {
     if (!mqtt_initialized)
@@ -56,11 +172,15 @@ bool mqtt_connect()
         Serial.print("MQTT connected to broker: ");
         Serial.println(MQTT_BROKER_IP);
 
+        // Each publish is written in one piece - send it without waiting for ACKs
+        netClient.setNoDelay(true);
+
         // Publish initial status
         mqttClient.publish(MQTT_TOPIC_STATUS, "online", true); // Retained message
 
-        // Reset retry counter
-        connection_retries = 0;
+        // Listen for configuration commands and report the active configuration
+        mqttClient.subscribe(MQTT_TOPIC_COMMAND);
+        mqtt_publish_config();
 
         return true;
     }
@@ -72,55 +192,236 @@ bool mqtt_connect()
     }
 }
 
-// Handle MQTT reconnection
+// Schedule the next connection attempt with exponential backoff and jitter
+static void mqtt_schedule_reconnect()
+{
+    // Spread attempts over 75-125% of the delay so devices don't reconnect in lockstep
+    unsigned long jitter = random(backoff_delay / 2 + 1);
+    unsigned long delay_ms = backoff_delay - backoff_delay / 4 + jitter;
+
+    next_connect_attempt = millis() + delay_ms;
+    mqtt_state = MQTT_STATE_BACKOFF;
+
+    Serial.print("MQTT reconnect in ");
+    Serial.print(delay_ms);
+    Serial.println(" ms");
+
+    backoff_delay = min(backoff_delay * 2, (unsigned long)MQTT_BACKOFF_MAX);
+}
+
+// Request an immediate reconnection attempt (e.g. after WiFi came back)
 void mqtt_reconnect()
 {
-    if (!mqtt_initialized || !WiFi.isConnected())
+    if (mqtt_state == MQTT_STATE_BACKOFF)
+    {
+        backoff_delay = MQTT_BACKOFF_MIN;
+        next_connect_attempt = millis();
+    }
+}
+
+// Close the broker connection cleanly (e.g. before deep sleep)
+void mqtt_disconnect()
+{
+    if (is_mqtt_connected())
+    {
+        mqttClient.disconnect();
+    }
+    mqtt_state = MQTT_STATE_DISCONNECTED;
+}
+
+// Check if MQTT is connected
+bool is_mqtt_connected()
+{
+    // Client is owned by the connect task while connecting - only touch it when connected
+    return mqtt_initialized && mqtt_state == MQTT_STATE_CONNECTED && mqttClient.connected();
+}
+
+// Get MQTT connection state
+mqtt_state_t get_mqtt_state()
+{
+    return mqtt_state;
+}
+
+// A full batch of the widest samples plus the PUBLISH header (fixed header, topic, MQTT 5 properties)
+static_assert(MQTT_BATCH_BUFFER_SIZE + sizeof(MQTT_TOPIC_BATCH) + 16 <= MQTT_BUFFER_SIZE,
+              "MQTT_BUFFER_SIZE cannot hold a full batch; lower MQTT_BATCH_MAX_SAMPLES");
+
+// Publish samples as one JSON message on the batch topic
+bool mqtt_publish_samples(const mqtt_sample_t *samples, uint8_t count, bool wifi_connected, bool sensor_ok)
+{
+    static char payload[MQTT_BATCH_BUFFER_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject();
+    json.addString("client_id", MQTT_CLIENT_ID);
+    json.addUInt("seq", batch_sequence);
+    json.addBool("wifi_connected", wifi_connected);
+    json.addBool("sensor_ok", sensor_ok);
+    json.beginArray("samples"); // [timestamp, height_mm, level_percent]
+    for (uint8_t i = 0; i < count; i++)
+    {
+        json.beginArray();
+        json.addUInt(NULL, samples[i].timestamp);
+        json.addInt(NULL, samples[i].height_mm);
+        json.addInt(NULL, samples[i].level_percent);
+        json.endArray();
+    }
+    json.endArray();
+    json.endObject();
+
+    if (json.overflowed() || !is_mqtt_connected() ||
+        !mqttClient.publish(MQTT_TOPIC_BATCH, (const uint8_t *)json.c_str(), json.length()))
+    {
+        return false;
+    }
+
+    batch_sequence++; // Lets subscribers spot missing batches
+    return true;
+}
+
+// Move the pending batch to the offline queue - everything queued later is newer
+static void mqtt_batch_to_queue()
+{
+    for (uint8_t i = 0; i < batch_count; i++)
+    {
+        mqtt_queue_push_sample(&batch_samples[i]);
+    }
+    batch_count = 0;
+}
+
+// Publish the pending batch as one JSON message
+static void mqtt_flush_batch()
+{
+    if (batch_count == 0)
     {
         return;
     }
 
-    unsigned long now = millis();
+    if (!mqtt_publish_samples(batch_samples, batch_count, batch_wifi_connected, batch_sensor_ok))
+    {
+        // Keep the samples for replay rather than losing the whole window
+        mqtt_batch_to_queue();
+    }
 
-    // Check if it's time to attempt reconnection
-    if (now - last_reconnect_attempt > MQTT_RECONNECT_INTERVAL)
+    batch_count = 0;
+}
+
+// Add a sample to the batch, flushing when it is full
+static void mqtt_batch_add(const mqtt_sample_t *sample)
+{
+    if (batch_count == 0)
     {
-        last_reconnect_attempt = now;
+        batch_start = millis();
+    }
 
-        // Don't retry indefinitely
-        if (connection_retries < MQTT_MAX_RETRIES)
+    batch_samples[batch_count++] = *sample;
+
+    if (batch_count == MQTT_BATCH_MAX_SAMPLES)
+    {
+        // In power-save mode a full batch waits in the queue for the next TX window
+        if (WIFI_POWER_SAVE)
+        {
+            mqtt_batch_to_queue();
+        }
+        else
         {
-            Serial.print("Attempting MQTT connection... ");
+            mqtt_flush_batch();
+        }
+    }
+}
 
-            if (mqtt_connect())
-            {
-                Serial.println("connected");
-            }
-            else
-            {
-                connection_retries++;
-                Serial.print("failed, retry ");
-                Serial.print(connection_retries);
-                Serial.print("/");
-                Serial.println(MQTT_MAX_RETRIES);
-            }
+// Keep a sample for a batch or for replay. Samples go out in timestamp order: the batch only fills while the
+// queue is empty, and anything queued goes behind a batch that could not be sent yet.
+static void mqtt_store_sample(const mqtt_sample_t *sample)
+{
+    if (MQTT_BATCH_ENABLED && is_mqtt_connected() && mqtt_queue_is_empty())
+    {
+        mqtt_batch_add(sample);
+        return;
+    }
+
+    mqtt_batch_to_queue();
+    mqtt_queue_push_sample(sample);
+}
+
+// Publish one replayed sample on the backlog topic - binary when the text topics are off
+static bool mqtt_publish_backlog(const mqtt_sample_t *sample, bool previous_boot, unsigned long now)
+{
+    if (MQTT_BINARY_PAYLOAD && MQTT_BINARY_ONLY)
+    {
+        // Same layout as the live record; 3 = age_ms, or 4 = true for a timestamp from before the reset
+        uint8_t payload[MQTT_CBOR_BUFFER_SIZE];
+        CborWriter cbor(payload, sizeof(payload));
+        cbor.beginMap(3);
+        cbor.addUInt(0);
+        cbor.addUInt(sample->timestamp);
+        cbor.addUInt(2);
+        cbor.beginArray(1);
+        cbor.beginArray(3);
+        cbor.addUInt(0); // Tank instance
+        cbor.addInt(sample->height_mm);
+        cbor.addInt(sample->level_percent);
+        if (previous_boot)
+        {
+            cbor.addUInt(4);
+            cbor.addBool(true);
         }
         else
         {
-            // Reset retry counter after a longer delay
-            if (now - last_reconnect_attempt > (MQTT_RECONNECT_INTERVAL * 10))
-            {
-                connection_retries = 0;
-                Serial.println("Resetting MQTT retry counter");
-            }
+            cbor.addUInt(3);
+            cbor.addUInt(now - sample->timestamp);
         }
+
+        return !cbor.overflowed() && mqttClient.publish(MQTT_TOPIC_BACKLOG, cbor.data(), cbor.length());
     }
+
+    char payload[MQTT_JSON_BUFFER_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject();
+    json.addUInt("timestamp", sample->timestamp);
+    if (previous_boot)
+    {
+        json.addBool("previous_boot", true); // Timestamp from the clock of the boot before the reset
+    }
+    else
+    {
+        json.addUInt("age_ms", now - sample->timestamp);
+    }
+    json.addInt("height_mm", sample->height_mm);
+    json.addInt("level_percent", sample->level_percent);
+    json.endObject();
+
+    return mqttClient.publish(MQTT_TOPIC_BACKLOG, (const uint8_t *)json.c_str(), json.length());
 }
 
-// Check if MQTT is connected
-bool is_mqtt_connected()
+// Replay queued samples in order, a few per interval so live data keeps flowing.
+// In a TX window the radio is up anyway, so up to a RAM queue's worth goes out at once.
+static void mqtt_replay_queue(bool tx_window)
 {
-    return mqtt_initialized && mqttClient.connected();
+    static unsigned long last_replay = 0;
+    unsigned long now = millis();
+
+    if (mqtt_queue_is_empty() || (!tx_window && now - last_replay < MQTT_REPLAY_INTERVAL))
+    {
+        return;
+    }
+    last_replay = now;
+
+    uint32_t limit = tx_window ? MQTT_QUEUE_RAM_SAMPLES : MQTT_REPLAY_BURST;
+    uint32_t replayed = 0;
+    mqtt_sample_t sample;
+    bool previous_boot;
+    while (replayed < limit && mqtt_queue_peek(&sample, &previous_boot))
+    {
+        if (!mqtt_publish_backlog(&sample, previous_boot, now))
+        {
+            break; // Keep the sample and retry next interval
+        }
+
+        mqtt_queue_pop();
+        replayed++;
+    }
+
+    mqtt_queue_note_replayed(replayed);
 }
 
 // MQTT loop handler - must be called regularly
@@ -131,20 +432,133 @@ void mqtt_loop()
         return;
     }
 
-    if (mqttClient.connected())
+    switch (mqtt_state)
     {
+    case MQTT_STATE_CONNECTED:
+        if (!mqttClient.connected())
+        {
+            Serial.println("MQTT connection lost");
+            mqtt_batch_to_queue(); // Ahead of the samples queued while disconnected
+            mqtt_schedule_reconnect();
+            break;
+        }
         mqttClient.loop(); // Handle MQTT client tasks
+
+        // In power-save mode queued and batched samples wait for the next TX window (mqtt_send_pending())
+        if (!WIFI_POWER_SAVE)
+        {
+            mqtt_replay_queue(false); // Drain samples buffered while disconnected
+
+            // Flush the batch once its window has elapsed
+            if (batch_count > 0 && millis() - batch_start >= MQTT_BATCH_WINDOW_MS)
+            {
+                mqtt_flush_batch();
+            }
+        }
+        break;
+
+    case MQTT_STATE_DISCONNECTED:
+    case MQTT_STATE_BACKOFF:
+        // Hand a connection attempt to the connect task once the backoff expired
+        if (WiFi.isConnected() && (long)(millis() - next_connect_attempt) >= 0)
+        {
+            connect_result = 0;
+            mqtt_state = MQTT_STATE_CONNECTING;
+            xTaskNotifyGive(connect_task);
+        }
+        break;
+
+    case MQTT_STATE_CONNECTING:
+        if (connect_result > 0)
+        {
+            mqtt_state = MQTT_STATE_CONNECTED;
+            backoff_delay = MQTT_BACKOFF_MIN;
+        }
+        else if (connect_result < 0)
+        {
+            mqtt_schedule_reconnect();
+        }
+        break;
     }
-    else
+}
+
+// Send queued and batched samples while the radio is up for a TX window (power-save mode)
+void mqtt_send_pending()
+{
+    if (!mqtt_initialized || mqtt_state != MQTT_STATE_CONNECTED)
+    {
+        return;
+    }
+
+    mqtt_replay_queue(true);
+    mqtt_flush_batch();
+}
+
+// Keep a sample that was superseded before it could be sent - replayed in order with the offline queue
+void mqtt_defer_sample(int height_mm, int level_percent, uint32_t timestamp)
+{
+    if (!mqtt_initialized)
     {
-        mqtt_reconnect(); // Attempt reconnection if disconnected
+        return;
+    }
+
+    mqtt_sample_t sample;
+    sample.timestamp = timestamp;
+    sample.height_mm = height_mm;
+    sample.level_percent = level_percent;
+    mqtt_store_sample(&sample);
+}
+
+// Check if the plain-text topics are enabled
+static bool mqtt_text_topics_enabled()
+{
+    return !(MQTT_BINARY_PAYLOAD && MQTT_BINARY_ONLY) && !MQTT_BATCH_ENABLED;
+}
+
+// Check the deadband and publish interval, marking the sample as published when due
+bool mqtt_publish_due(int height_mm)
+{
+    runtime_config_t config = get_runtime_config();
+    unsigned long now = millis();
+
+    if (published_once)
+    {
+        if (config.publish_ms > 0 && now - last_published_time < config.publish_ms)
+        {
+            return false;
+        }
+        if ((uint32_t)abs(height_mm - last_published_height) < config.deadband_mm)
+        {
+            return false;
+        }
     }
+
+    last_published_height = height_mm;
+    last_published_time = now;
+    published_once = true;
+    return true;
 }
 
 // Publish sensor data to individual topics
 void mqtt_publish_sensor_data(int height_mm, String level_percent)
 {
-    if (!is_mqtt_connected())
+    if (!mqtt_initialized)
+    {
+        return;
+    }
+
+    if (!is_mqtt_connected() || MQTT_BATCH_ENABLED)
+    {
+        // Buffered for replay once the broker is reachable again, or collected for the next batch
+        mqtt_sample_t sample;
+        sample.timestamp = millis();
+        sample.height_mm = height_mm;
+        sample.level_percent = level_percent.toInt();
+        mqtt_store_sample(&sample);
+        return;
+    }
+
+    if (!mqtt_text_topics_enabled())
     {
         return;
     }
@@ -160,7 +574,7 @@ void mqtt_publish_sensor_data(int height_mm, String level_percent)
 // Publish NMEA XDR data
 void mqtt_publish_nmea_data(String nmea_xdr)
 {
-    if (!is_mqtt_connected())
+    if (!is_mqtt_connected() || !mqtt_text_topics_enabled())
     {
         return;
     }
@@ -176,31 +590,229 @@ void mqtt_publish_status_data(bool wifi_connected, bool sensor_ok)
         return;
     }
 
-    // Publish WiFi status
-    mqttClient.publish(MQTT_TOPIC_WIFI_STATUS, wifi_connected ? "connected" : "disconnected");
+    if (mqtt_text_topics_enabled())
+    {
+        // Publish WiFi status
+        mqttClient.publish(MQTT_TOPIC_WIFI_STATUS, wifi_connected ? "connected" : "disconnected");
+
+        // Publish sensor status
+        mqttClient.publish(MQTT_TOPIC_SENSOR_STATUS, sensor_ok ? "ok" : "error");
+    }
+
+    // Publish offline queue metrics
+    mqtt_queue_stats_t stats;
+    get_mqtt_queue_stats(&stats);
+
+    char payload[MQTT_JSON_BUFFER_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject();
+    json.addUInt("depth", stats.depth);
+    json.addUInt("spilled_depth", stats.spilled_depth);
+    json.addUInt("queued", stats.queued_total);
+    json.addUInt("spilled", stats.spilled_total);
+    json.addUInt("recovered", stats.recovered);
+    json.addUInt("replayed", stats.replayed_total);
+    json.addUInt("dropped", stats.dropped_total);
+    json.addUInt("replay_rate", stats.replay_rate);
+    json.endObject();
+    mqttClient.publish(MQTT_TOPIC_QUEUE_STATUS, (const uint8_t *)json.c_str(), json.length());
+
+    // Publish radio power mode and radio-on estimate
+    JsonWriter power_json(payload, sizeof(payload));
+    power_json.beginObject();
+    power_json.addBool("power_save", WIFI_POWER_SAVE);
+    power_json.addUInt("listen_interval", WIFI_POWER_SAVE ? WIFI_LISTEN_INTERVAL : 1);
+    power_json.addUInt("radio_on_ms_per_hour", get_wifi_radio_on_ms_per_hour());
+    power_json.addUInt("tx_windows", get_wifi_tx_window_count());
+    power_json.addUInt("wifi_connect_ms", get_wifi_connect_ms());
+    power_json.addUInt("first_udp_ms", get_nmea_first_datagram_ms());
+
+    // CPU residency at full speed vs. minimum frequency/light sleep
+    power_stats_t cpu;
+    get_power_stats(&cpu);
+    power_json.addUInt("cpu_high_ms", cpu.high_ms);
+    power_json.addUInt("cpu_low_ms", cpu.low_ms);
+    power_json.addBool("scaling", cpu.scaling);
+    power_json.addBool("light_sleep", cpu.light_sleep);
+    power_json.addUInt("acquire_us_max", cpu.acquire_us_max);
+    power_json.addUInt("render_ms", cpu.lock_ms[POWER_LOCK_RENDER]);
+    power_json.addUInt("flush_ms", cpu.lock_ms[POWER_LOCK_FLUSH]);
+    power_json.addUInt("network_ms", cpu.lock_ms[POWER_LOCK_NETWORK]);
+    power_json.endObject();
+    if (!power_json.overflowed())
+    {
+        mqttClient.publish(MQTT_TOPIC_POWER, (const uint8_t *)power_json.c_str(), power_json.length());
+    }
+
+    // Publish display redraw statistics for the last second
+    display_stats_t display;
+    get_display_stats(&display);
+
+    JsonWriter display_json(payload, sizeof(payload));
+    display_json.beginObject();
+    display_json.addUInt("flushed_px_per_s", display.flushed_pixels_per_s);
+    display_json.addUInt("flushes_per_s", display.flushes_per_s);
+    display_json.addUInt("render_us_per_s", display.render_us_per_s);
+    display_json.addUInt("flush_wait_us_per_s", display.flush_wait_us_per_s);
+    display_json.addUInt("frame_us_max", display.frame_us_max);
+    display_json.addUInt("queue_latency_us_avg", display.queue_latency_us_avg);
+    display_json.addUInt("queue_latency_us_max", display.queue_latency_us_max);
+    display_json.addUInt("queue_dropped", display.queue_dropped);
+    display_json.addUInt("repairs", display.repairs);
+    display_json.addUInt("full_frame_us", display.benchmark_frame_us);
+    display_json.addUInt("full_frame_wait_us", display.benchmark_wait_us);
+    display_json.addUInt("screen_switch_us", display.screen_switch_us);
+    display_json.addUInt("screen_switch_us_max", display.screen_switch_us_max);
+    display_json.addUInt("screen_heap_bytes", display.screen_heap_bytes);
+    display_json.addUInt("heap_min_free", display.heap_min_free);
+    display_json.addUInt("touch_reads_per_s", display.touch_reads_per_s);
+    display_json.addUInt("touch_read_us_avg", display.touch_read_us_avg);
+    display_json.addUInt("touch_read_us_max", display.touch_read_us_max);
+    display_json.addUInt("touch_wake_us", display.touch_wake_us);
+    display_json.addUInt("touch_spurious", display.touch_spurious);
+    display_json.endObject();
+    if (!display_json.overflowed())
+    {
+        mqttClient.publish(MQTT_TOPIC_DISPLAY, (const uint8_t *)display_json.c_str(), display_json.length());
+    }
+
+    // Publish per-task scheduling statistics
+    char stats_payload[MQTT_SCHEDULER_BUFFER_SIZE];
+    JsonWriter scheduler_json(stats_payload, sizeof(stats_payload));
+    scheduler_json.beginObject();
+    for (int i = 0; i < scheduler_task_count(); i++)
+    {
+        scheduler_stats_t task;
+        get_scheduler_stats(i, &task);
+        scheduler_json.beginObject(task.name);
+        scheduler_json.addUInt("runs", task.runs);
+        scheduler_json.addUInt("jitter_avg_us", task.jitter_avg_us);
+        scheduler_json.addUInt("jitter_max_us", task.jitter_max_us);
+        scheduler_json.addUInt("run_max_us", task.run_max_us);
+        scheduler_json.addUInt("overruns", task.overruns);
+        scheduler_json.addUInt("skipped", task.skipped);
+        scheduler_json.endObject();
+    }
+    scheduler_json.endObject();
+    if (!scheduler_json.overflowed())
+    {
+        mqttClient.publish(MQTT_TOPIC_SCHEDULER, (const uint8_t *)scheduler_json.c_str(), scheduler_json.length());
+    }
+
+    // Publish per-task CPU load and the sensor snapshot counters
+    task_load_t loads[MONITOR_TASK_COUNT];
+    get_task_loads(loads);
+    sensor_snapshot_stats_t snapshot;
+    get_sensor_snapshot_stats(&snapshot);
+
+    JsonWriter tasks_json(stats_payload, sizeof(stats_payload));
+    tasks_json.beginObject();
+    for (int i = 0; i < MONITOR_TASK_COUNT; i++)
+    {
+        if (loads[i].core < 0)
+        {
+            continue;
+        }
+        tasks_json.beginObject(loads[i].name);
+        tasks_json.addInt("core", loads[i].core);
+        tasks_json.addUInt("cpu_permille", loads[i].cpu_permille);
+        tasks_json.addUInt("stack_free", loads[i].stack_free);
+        tasks_json.endObject();
+    }
+    tasks_json.beginObject("snapshot");
+    tasks_json.addUInt("writes", snapshot.writes);
+    tasks_json.addUInt("reads", snapshot.reads);
+    tasks_json.addUInt("retries", snapshot.retries);
+    tasks_json.addUInt("torn", snapshot.torn);
+    tasks_json.endObject();
+    tasks_json.endObject();
+    if (!tasks_json.overflowed())
+    {
+        mqttClient.publish(MQTT_TOPIC_TASKS, (const uint8_t *)tasks_json.c_str(), tasks_json.length());
+    }
 
-    // Publish sensor status
-    mqttClient.publish(MQTT_TOPIC_SENSOR_STATUS, sensor_ok ? "ok" : "error");
+#if MQTT_USE_TLS
+    // Publish TLS handshake metrics
+    tls_stats_t tls;
+    netClient.getStats(&tls);
+
+    JsonWriter tls_json(payload, sizeof(payload));
+    tls_json.beginObject();
+    tls_json.addUInt("full", tls.full_handshakes);
+    tls_json.addUInt("resumed", tls.resumed_handshakes);
+    tls_json.addUInt("failed", tls.failed_handshakes);
+    tls_json.addUInt("last_ms", tls.last_handshake_ms);
+    tls_json.addBool("last_resumed", tls.last_resumed);
+    tls_json.addUInt("avg_full_ms", tls.avg_full_ms);
+    tls_json.addUInt("avg_resumed_ms", tls.avg_resumed_ms);
+    tls_json.endObject();
+    mqttClient.publish(MQTT_TOPIC_TLS_STATUS, (const uint8_t *)tls_json.c_str(), tls_json.length());
+#endif
 }
 
 // Publish comprehensive JSON data (useful for home automation systems)
-void mqtt_publish_json_data(int height_mm, String level_percent, bool wifi_connected, bool sensor_ok)
+void mqtt_publish_json_data(int height_mm, const String &level_percent, bool wifi_connected, bool sensor_ok)
 {
-    if (!is_mqtt_connected())
+    // Status goes out with the next batch when batching
+    batch_wifi_connected = wifi_connected;
+    batch_sensor_ok = sensor_ok;
+
+    if (!is_mqtt_connected() || !mqtt_text_topics_enabled())
     {
         return;
     }
 
-    // Create JSON payload
-    String json = "{";
-    json += "\"height_mm\":" + String(height_mm) + ",";
-    json += "\"level_percent\":" + level_percent + ",";
-    json += "\"wifi_connected\":" + String(wifi_connected ? "true" : "false") + ",";
-    json += "\"sensor_ok\":" + String(sensor_ok ? "true" : "false") + ",";
-    json += "\"timestamp\":" + String(millis()) + ",";
-    json += "\"client_id\":\"" + String(MQTT_CLIENT_ID) + "\"";
-    json += "}";
+    // Build JSON payload in a fixed stack buffer - no heap allocations
+    char payload[MQTT_JSON_BUFFER_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject();
+    json.addInt("height_mm", height_mm);
+    json.addInt("level_percent", level_percent.toInt());
+    json.addBool("wifi_connected", wifi_connected);
+    json.addBool("sensor_ok", sensor_ok);
+    json.addUInt("timestamp", millis());
+    json.addString("client_id", MQTT_CLIENT_ID);
+    json.endObject();
+
+    if (json.overflowed())
+    {
+        Serial.println("MQTT JSON payload too large");
+        return;
+    }
 
     // Publish to status topic
-    mqttClient.publish(MQTT_TOPIC_STATUS, json.c_str());
-}
\ No newline at end of file
+    mqttClient.publish(MQTT_TOPIC_STATUS, (const uint8_t *)json.c_str(), json.length());
+}
+
+// Publish packed binary record: {0: timestamp, 1: status bits, 2: [[tank, height_mm, level_percent]]}
+void mqtt_publish_binary_data(int height_mm, const String &level_percent, bool wifi_connected, bool sensor_ok)
+{
+    if (!MQTT_BINARY_PAYLOAD || !is_mqtt_connected())
+    {
+        return;
+    }
+
+    uint8_t status = (wifi_connected ? 0x01 : 0) | (sensor_ok ? 0x02 : 0);
+
+    uint8_t payload[MQTT_CBOR_BUFFER_SIZE];
+    CborWriter cbor(payload, sizeof(payload));
+    cbor.beginMap(3);
+    cbor.addUInt(0);
+    cbor.addUInt(millis());
+    cbor.addUInt(1);
+    cbor.addUInt(status);
+    cbor.addUInt(2);
+    cbor.beginArray(1); // One entry per tank
+    cbor.beginArray(3);
+    cbor.addUInt(0); // Tank instance
+    cbor.addInt(height_mm);
+    cbor.addInt(level_percent.toInt());
+
+    if (cbor.overflowed())
+    {
+        Serial.println("MQTT binary payload too large");
+        return;
+    }
+
+    mqttClient.publish(MQTT_TOPIC_BINARY, cbor.data(), cbor.length());
+}
@@ -12,6 +12,7 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <PubSubClient.h>
+#include "mqtt_queue.h"
 
 // MQTT Configuration - adjust these for your MQTT broker
 #define MQTT_BROKER_IP "192.168.1.100" // Change to your MQTT broker IP
@@ -20,6 +21,19 @@
 #define MQTT_USERNAME "" // Leave empty if no authentication required
 #define MQTT_PASSWORD "" // Leave empty if no authentication required
 
+// Protocol version - MQTT 5 uses topic aliases so repeated publishes skip the topic string
+#define MQTT_USE_V5 0             // 0 = MQTT 3.1.1 (PubSubClient), 1 = MQTT 5 (Mqtt5Client)
+#define MQTT5_MESSAGE_EXPIRY 600  // Seconds the broker keeps undelivered messages (0 = forever)
+
+// TLS - encrypts the broker connection on shared networks (CA certificate in mqtt_ca_cert.h)
+#define MQTT_USE_TLS 0                         // 1 = connect with TLS on MQTT_TLS_PORT
+#define MQTT_TLS_PORT 8883
+#define MQTT_TLS_SERVER_NAME "mqtt.local"      // Name in the broker certificate, also sent as SNI
+#define MQTT_TLS_SESSION_NVS 0                 // 1 = keep the TLS session in NVS so reboots resume too. The session
+                                               // holds the master secret and NVS is not encrypted by default, so
+                                               // anyone who can read the flash can decrypt recorded sessions
+#define MQTT_TLS_INSECURE 0                    // 1 = allow an empty CA certificate (no broker verification, testing only)
+
 // MQTT Topics
 #define MQTT_TOPIC_STATUS "sensors/level/status"
 #define MQTT_TOPIC_LEVEL_MM "sensors/level/height_mm"
@@ -27,20 +41,71 @@
 #define MQTT_TOPIC_NMEA_XDR "sensors/level/nmea_xdr"
 #define MQTT_TOPIC_WIFI_STATUS "sensors/level/wifi_status"
 #define MQTT_TOPIC_SENSOR_STATUS "sensors/level/sensor_status"
+#define MQTT_TOPIC_BACKLOG "sensors/level/backlog"    // Samples replayed after a disconnect
+#define MQTT_TOPIC_QUEUE_STATUS "sensors/level/queue" // Offline queue metrics
+#define MQTT_TOPIC_BINARY "sensors/level/bin"         // Packed CBOR record
+#define MQTT_TOPIC_BATCH "sensors/level/batch"        // Batched samples (JSON array)
+#define MQTT_TOPIC_TLS_STATUS "sensors/level/tls"     // TLS handshake metrics
+#define MQTT_TOPIC_POWER "sensors/level/power"        // Radio power mode and radio-on estimate
+#define MQTT_TOPIC_DISPLAY "sensors/level/display"    // Display redraw statistics
+#define MQTT_TOPIC_SCHEDULER "sensors/level/scheduler" // Per-task scheduling statistics
+#define MQTT_TOPIC_TASKS "sensors/level/tasks"        // Per-task CPU load and snapshot handoff counters
+#define MQTT_TOPIC_COMMAND "sensors/level/cmd"        // Runtime configuration updates (JSON)
+#define MQTT_TOPIC_CONFIG "sensors/level/config"      // Active configuration (retained)
+
+// Batched publishing for high-rate logging - replaces the per-sample topics when enabled
+#define MQTT_BATCH_ENABLED 0        // Accumulate samples and publish them as one message
+#define MQTT_BATCH_WINDOW_MS 10000  // Flush at least this often...
+#define MQTT_BATCH_MAX_SAMPLES 32   // ...or as soon as this many samples are waiting
+
+// Binary payload for metered links (LTE/satellite)
+#define MQTT_BINARY_PAYLOAD 0 // Publish the packed CBOR record on MQTT_TOPIC_BINARY
+#define MQTT_BINARY_ONLY 0    // Skip the plain-text topics and publish only the binary record
+
+// Connection retry configuration - exponential backoff with jitter
+#define MQTT_BACKOFF_MIN 1000         // 1 second before the first retry
+#define MQTT_BACKOFF_MAX 60000        // Retry at least once a minute
+#define MQTT_CONNACK_TIMEOUT 5        // Seconds to wait for the broker's CONNACK
+#if MQTT_USE_TLS
+#define MQTT_CONNECT_TASK_STACK 8192  // Stack for the background connect task (TLS handshake)
+#else
+#define MQTT_CONNECT_TASK_STACK 4096  // Stack for the background connect task
+#endif
+
+// Connection states
+enum mqtt_state_t
+{
+    MQTT_STATE_DISCONNECTED, // Not connected, no attempt scheduled yet
+    MQTT_STATE_BACKOFF,      // Waiting before the next attempt
+    MQTT_STATE_CONNECTING,   // Attempt running in the connect task
+    MQTT_STATE_CONNECTED
+};
 
-// Connection retry configuration
-#define MQTT_RECONNECT_INTERVAL 5000 // 5 seconds between reconnection attempts
-#define MQTT_MAX_RETRIES 5           // Maximum connection retries before giving up
+// Payload buffers (stack allocated)
+#define MQTT_JSON_BUFFER_SIZE 640 // JSON status payload (display statistics are the largest)
+#define MQTT_CBOR_BUFFER_SIZE 64  // Binary record payload
+#define MQTT_SCHEDULER_BUFFER_SIZE 896 // Scheduler and task statistics payloads (~130 bytes per task)
+#define MQTT_BATCH_SAMPLE_MAX_SIZE 27 // Widest batch sample: [4294967295,-32768,-32768],
+#define MQTT_BATCH_HEADER_MAX_SIZE (sizeof(MQTT_CLIENT_ID) + 87) // Client ID, seq, flags, brackets and NUL
+#define MQTT_BATCH_BUFFER_SIZE (MQTT_BATCH_HEADER_MAX_SIZE + MQTT_BATCH_SAMPLE_MAX_SIZE * MQTT_BATCH_MAX_SAMPLES)
+#define MQTT_BUFFER_SIZE 1024      // PubSubClient packet buffer, must hold a full batch
 
 // Function declarations
 void mqtt_init();
 bool mqtt_connect();
 void mqtt_reconnect();
+void mqtt_disconnect();
 bool is_mqtt_connected();
+mqtt_state_t get_mqtt_state();
 void mqtt_loop();
+void mqtt_send_pending();
+void mqtt_defer_sample(int height_mm, int level_percent, uint32_t timestamp);
+bool mqtt_publish_due(int height_mm);
 void mqtt_publish_sensor_data(int height_mm, String level_percent);
 void mqtt_publish_nmea_data(String nmea_xdr);
 void mqtt_publish_status_data(bool wifi_connected, bool sensor_ok);
-void mqtt_publish_json_data(int height_mm, String level_percent, bool wifi_connected, bool sensor_ok);
+void mqtt_publish_json_data(int height_mm, const String &level_percent, bool wifi_connected, bool sensor_ok);
+void mqtt_publish_binary_data(int height_mm, const String &level_percent, bool wifi_connected, bool sensor_ok);
+bool mqtt_publish_samples(const mqtt_sample_t *samples, uint8_t count, bool wifi_connected, bool sensor_ok);
 
 #endif // MQTT_H
\ No newline at end of file
@@ -0,0 +1,618 @@
+#include "mqtt5_client.h"
+
+// Packet types (upper nibble of the fixed header)
+#define MQTT5_CONNECT 0x10
+#define MQTT5_CONNACK 0x20
+#define MQTT5_PUBLISH 0x30
+#define MQTT5_SUBSCRIBE 0x82 // Includes the reserved flag bits
+#define MQTT5_PINGREQ 0xC0
+#define MQTT5_PINGRESP 0xD0
+#define MQTT5_DISCONNECT 0xE0
+
+// Properties used by this client
+#define MQTT5_PROP_MESSAGE_EXPIRY 0x02
+#define MQTT5_PROP_RECEIVE_MAXIMUM 0x21
+#define MQTT5_PROP_TOPIC_ALIAS_MAXIMUM 0x22
+#define MQTT5_PROP_TOPIC_ALIAS 0x23
+#define MQTT5_PROP_MAXIMUM_PACKET_SIZE 0x27
+
+// Room for the fixed header in front of every packet built in the buffer
+#define MQTT5_HEADER_SPACE 5
+
+// Big-endian field helpers
+static size_t put_u16(uint8_t *buffer, size_t pos, uint16_t value)
+{
+    buffer[pos++] = value >> 8;
+    buffer[pos++] = value & 0xFF;
+    return pos;
+}
+
+static size_t put_u32(uint8_t *buffer, size_t pos, uint32_t value)
+{
+    pos = put_u16(buffer, pos, value >> 16);
+    return put_u16(buffer, pos, value & 0xFFFF);
+}
+
+static size_t put_string(uint8_t *buffer, size_t pos, const char *text)
+{
+    size_t length = strlen(text);
+    pos = put_u16(buffer, pos, length);
+    memcpy(buffer + pos, text, length);
+    return pos + length;
+}
+
+// Size of a property value by identifier, -1 for variable-length types
+static int property_size(uint8_t id)
+{
+    switch (id)
+    {
+    case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+        return 1;
+    case 0x13: case 0x21: case 0x22: case 0x23:
+        return 2;
+    case 0x02: case 0x11: case 0x18: case 0x27:
+        return 4;
+    default:
+        return -1;
+    }
+}
+
+Mqtt5Client::Mqtt5Client(Client &client)
+    : client(&client), host(NULL), port(1883), keep_alive(60), socket_timeout(15), message_expiry(0),
+      callback(NULL), next_packet_id(1),
+      buffer(NULL), buffer_size(0), connection_state(MQTT5_DISCONNECTED),
+      last_out_activity(0), last_in_activity(0), ping_outstanding(false),
+      alias_count(0), server_alias_maximum(0), bytes_sent(0), publish_count(0)
+{
+    setBufferSize(MQTT5_DEFAULT_BUFFER_SIZE);
+}
+
+Mqtt5Client::~Mqtt5Client()
+{
+    free(buffer);
+}
+
+Mqtt5Client &Mqtt5Client::setServer(const char *host, uint16_t port)
+{
+    this->host = host;
+    this->port = port;
+    return *this;
+}
+
+Mqtt5Client &Mqtt5Client::setKeepAlive(uint16_t seconds)
+{
+    keep_alive = seconds;
+    return *this;
+}
+
+Mqtt5Client &Mqtt5Client::setSocketTimeout(uint16_t seconds)
+{
+    socket_timeout = seconds;
+    return *this;
+}
+
+Mqtt5Client &Mqtt5Client::setMessageExpiry(uint32_t seconds)
+{
+    message_expiry = seconds;
+    return *this;
+}
+
+// Handler for PUBLISH packets on subscribed topics
+Mqtt5Client &Mqtt5Client::setCallback(mqtt5_callback_t callback)
+{
+    this->callback = callback;
+    return *this;
+}
+
+// Resize the packet buffer (allocated once at startup)
+bool Mqtt5Client::setBufferSize(uint16_t size)
+{
+    uint8_t *resized = (uint8_t *)realloc(buffer, size);
+    if (resized == NULL)
+    {
+        return false;
+    }
+    buffer = resized;
+    buffer_size = size;
+    return true;
+}
+
+bool Mqtt5Client::connect(const char *id)
+{
+    return connect(id, NULL, NULL);
+}
+
+// Open TCP connection, send CONNECT and wait for CONNACK (blocking)
+bool Mqtt5Client::connect(const char *id, const char *user, const char *pass)
+{
+    if (connected())
+    {
+        return true;
+    }
+
+    if (!client->connected() && !client->connect(host, port))
+    {
+        connection_state = MQTT5_CONNECT_FAILED;
+        return false;
+    }
+
+    size_t needed = MQTT5_HEADER_SPACE + 10 + 10 + 2 + strlen(id) +
+                    (user ? 2 + strlen(user) : 0) + (pass ? 2 + strlen(pass) : 0);
+    if (needed > buffer_size)
+    {
+        client->stop();
+        connection_state = MQTT5_CONNECT_FAILED;
+        return false;
+    }
+
+    // Variable header: protocol name, level 5, flags, keep alive
+    size_t pos = MQTT5_HEADER_SPACE;
+    pos = put_string(buffer, pos, "MQTT");
+    buffer[pos++] = 5;
+    buffer[pos++] = 0x02 | (user ? 0x80 : 0) | (pass ? 0x40 : 0); // Clean start
+    pos = put_u16(buffer, pos, keep_alive);
+
+    // Properties: receive maximum and the largest packet we can take
+    buffer[pos++] = 8;
+    buffer[pos++] = MQTT5_PROP_RECEIVE_MAXIMUM;
+    pos = put_u16(buffer, pos, MQTT5_RECEIVE_MAXIMUM);
+    buffer[pos++] = MQTT5_PROP_MAXIMUM_PACKET_SIZE;
+    pos = put_u32(buffer, pos, buffer_size);
+
+    // Payload
+    pos = put_string(buffer, pos, id);
+    if (user)
+    {
+        pos = put_string(buffer, pos, user);
+    }
+    if (pass)
+    {
+        pos = put_string(buffer, pos, pass);
+    }
+
+    if (!writePacket(MQTT5_CONNECT, pos - MQTT5_HEADER_SPACE))
+    {
+        client->stop();
+        connection_state = MQTT5_CONNECT_FAILED;
+        return false;
+    }
+
+    // Wait for CONNACK
+    unsigned long start = millis();
+    while (!client->available())
+    {
+        if (millis() - start >= socket_timeout * 1000UL || !client->connected())
+        {
+            client->stop();
+            connection_state = MQTT5_CONNECTION_TIMEOUT;
+            return false;
+        }
+        delay(10);
+    }
+
+    uint8_t type;
+    uint32_t length;
+    if (!readPacket(&type, &length) || type != MQTT5_CONNACK || !parseConnack(length))
+    {
+        client->stop();
+        if (connection_state == MQTT5_CONNECTED)
+        {
+            connection_state = MQTT5_CONNECT_FAILED;
+        }
+        return false;
+    }
+
+    alias_count = 0;
+    ping_outstanding = false;
+    last_in_activity = last_out_activity = millis();
+    return true;
+}
+
+// Check CONNACK reason code and pick up the broker's topic alias limit. Every length read from the packet is
+// checked against the received data, and a CONNACK that does not add up is rejected.
+bool Mqtt5Client::parseConnack(uint32_t length)
+{
+    size_t packet_end = MQTT5_HEADER_SPACE + length;
+    connection_state = MQTT5_CONNECT_FAILED;
+
+    if (length < 3)
+    {
+        return false;
+    }
+
+    uint8_t reason = buffer[MQTT5_HEADER_SPACE + 1];
+    if (reason != 0)
+    {
+        connection_state = reason; // MQTT 5 reason code, e.g. 0x87 not authorized
+        return false;
+    }
+
+    server_alias_maximum = 0; // Broker allows no aliases unless it says otherwise
+
+    // Property length (variable byte integer, at most 4 bytes), properties follow
+    size_t pos = MQTT5_HEADER_SPACE + 2;
+    size_t properties_length = 0;
+    uint8_t shift = 0;
+    uint8_t digit;
+    do
+    {
+        if (pos >= packet_end || shift >= 28)
+        {
+            return false;
+        }
+        digit = buffer[pos++];
+        properties_length |= (size_t)(digit & 0x7F) << shift;
+        shift += 7;
+    } while (digit & 0x80);
+
+    if (properties_length > packet_end - pos)
+    {
+        return false;
+    }
+
+    size_t end = pos + properties_length;
+    while (pos < end)
+    {
+        uint8_t id = buffer[pos++];
+        int size = property_size(id);
+        int fields; // Length-prefixed strings or binary values
+        switch (id)
+        {
+        case 0x26: // User property: string pair
+            fields = 2;
+            break;
+        case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F: // Strings and authentication data
+            fields = 1;
+            break;
+        default:
+            fields = 0;
+            break;
+        }
+
+        if (size > 0)
+        {
+            if ((size_t)size > end - pos)
+            {
+                return false;
+            }
+            if (id == MQTT5_PROP_TOPIC_ALIAS_MAXIMUM)
+            {
+                server_alias_maximum = (buffer[pos] << 8) | buffer[pos + 1];
+            }
+            pos += size;
+            continue;
+        }
+
+        if (fields == 0)
+        {
+            return false; // Not a CONNACK property - its size is unknown
+        }
+
+        for (int i = 0; i < fields; i++)
+        {
+            if (end - pos < 2)
+            {
+                return false;
+            }
+            size_t field_length = (buffer[pos] << 8) | buffer[pos + 1];
+            pos += 2;
+            if (field_length > end - pos)
+            {
+                return false;
+            }
+            pos += field_length;
+        }
+    }
+
+    connection_state = MQTT5_CONNECTED;
+    return true;
+}
+
+void Mqtt5Client::disconnect()
+{
+    if (client->connected())
+    {
+        buffer[MQTT5_HEADER_SPACE] = 0x00; // Normal disconnection
+        writePacket(MQTT5_DISCONNECT, 1);
+    }
+    client->stop();
+    connection_state = MQTT5_DISCONNECTED;
+}
+
+bool Mqtt5Client::connected()
+{
+    if (connection_state != MQTT5_CONNECTED)
+    {
+        return false;
+    }
+
+    if (!client->connected())
+    {
+        client->stop();
+        connection_state = MQTT5_CONNECTION_LOST;
+        return false;
+    }
+    return true;
+}
+
+// Read one byte, waiting up to the socket timeout
+bool Mqtt5Client::readByte(uint8_t *value)
+{
+    unsigned long start = millis();
+    while (!client->available())
+    {
+        if (millis() - start >= socket_timeout * 1000UL)
+        {
+            return false;
+        }
+        delay(1);
+    }
+    *value = client->read();
+    return true;
+}
+
+// Read a packet into the buffer (payload starts at MQTT5_HEADER_SPACE)
+bool Mqtt5Client::readPacket(uint8_t *type, uint32_t *length)
+{
+    uint8_t byte;
+    if (!readByte(type))
+    {
+        return false;
+    }
+
+    // Remaining length (variable byte integer)
+    uint32_t value = 0;
+    uint32_t multiplier = 1;
+    do
+    {
+        if (!readByte(&byte) || multiplier > 128 * 128 * 128)
+        {
+            return false;
+        }
+        value += (byte & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while (byte & 0x80);
+
+    // Packets larger than the buffer are drained and dropped
+    bool fits = value <= (uint32_t)(buffer_size - MQTT5_HEADER_SPACE);
+    for (uint32_t i = 0; i < value; i++)
+    {
+        if (!readByte(&byte))
+        {
+            return false;
+        }
+        if (fits)
+        {
+            buffer[MQTT5_HEADER_SPACE + i] = byte;
+        }
+    }
+
+    *length = value;
+    return fits;
+}
+
+// Prepend the fixed header to a packet built at MQTT5_HEADER_SPACE and send it in one write
+bool Mqtt5Client::writePacket(uint8_t header, size_t length)
+{
+    uint8_t encoded[4];
+    uint8_t count = 0;
+    size_t value = length;
+    do
+    {
+        uint8_t digit = value % 128;
+        value /= 128;
+        encoded[count++] = digit | (value > 0 ? 0x80 : 0);
+    } while (value > 0 && count < 4);
+
+    size_t start = MQTT5_HEADER_SPACE - 1 - count;
+    buffer[start] = header;
+    memcpy(buffer + start + 1, encoded, count);
+
+    size_t total = 1 + count + length;
+    size_t written = client->write(buffer + start, total);
+    last_out_activity = millis();
+    bytes_sent += written;
+    return written == total;
+}
+
+// Handle keep alive and incoming packets - must be called regularly
+bool Mqtt5Client::loop()
+{
+    if (!connected())
+    {
+        return false;
+    }
+
+    unsigned long now = millis();
+    unsigned long keep_alive_ms = keep_alive * 1000UL;
+
+    if (keep_alive_ms > 0 && (now - last_in_activity > keep_alive_ms || now - last_out_activity > keep_alive_ms))
+    {
+        if (ping_outstanding)
+        {
+            // No PINGRESP within a keep alive period
+            client->stop();
+            connection_state = MQTT5_CONNECTION_TIMEOUT;
+            return false;
+        }
+
+        writePacket(MQTT5_PINGREQ, 0);
+        ping_outstanding = true;
+        last_in_activity = now;
+    }
+
+    if (client->available())
+    {
+        uint8_t type;
+        uint32_t length;
+        if (readPacket(&type, &length))
+        {
+            last_in_activity = millis();
+            switch (type & 0xF0)
+            {
+            case MQTT5_PINGRESP:
+                ping_outstanding = false;
+                break;
+            case MQTT5_PUBLISH:
+                handlePublish(type & 0x0F, length);
+                break;
+            case MQTT5_DISCONNECT:
+                client->stop();
+                connection_state = MQTT5_CONNECTION_LOST;
+                return false;
+            default:
+                break; // SUBACK and anything else needs no action at QoS 0
+            }
+        }
+    }
+    return true;
+}
+
+// Pass an incoming PUBLISH to the callback
+void Mqtt5Client::handlePublish(uint8_t flags, uint32_t length)
+{
+    size_t pos = MQTT5_HEADER_SPACE;
+    size_t end = MQTT5_HEADER_SPACE + length;
+
+    if (!callback || length < 3)
+    {
+        return;
+    }
+
+    // Topic name - the callback gets a NUL-terminated copy
+    size_t topic_length = (buffer[pos] << 8) | buffer[pos + 1];
+    pos += 2;
+    if (topic_length == 0 || topic_length >= MQTT5_MAX_TOPIC_LENGTH || pos + topic_length > end)
+    {
+        return; // We never allow inbound aliases, so an empty topic is invalid
+    }
+    char topic[MQTT5_MAX_TOPIC_LENGTH];
+    memcpy(topic, buffer + pos, topic_length);
+    topic[topic_length] = '\0';
+    pos += topic_length;
+
+    // Packet identifier is only present for QoS 1/2
+    if (flags & 0x06)
+    {
+        pos += 2;
+    }
+
+    // Skip properties (variable byte integer length)
+    size_t properties_length = 0;
+    uint8_t shift = 0;
+    do
+    {
+        if (pos >= end)
+        {
+            return;
+        }
+        properties_length |= (size_t)(buffer[pos] & 0x7F) << shift;
+        shift += 7;
+    } while ((buffer[pos++] & 0x80) && shift < 28);
+    pos += properties_length;
+
+    if (pos > end)
+    {
+        return;
+    }
+
+    callback(topic, buffer + pos, end - pos);
+}
+
+// Find the alias assigned to a topic (1-based), 0 if none
+int Mqtt5Client::findAlias(const char *topic)
+{
+    for (uint8_t i = 0; i < alias_count; i++)
+    {
+        if (strcmp(alias_topics[i], topic) == 0)
+        {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+bool Mqtt5Client::publish(const char *topic, const char *payload, bool retained)
+{
+    return publish(topic, (const uint8_t *)payload, strlen(payload), retained);
+}
+
+// Publish at QoS 0, replacing the topic with an alias after its first use
+bool Mqtt5Client::publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained)
+{
+    if (!connected())
+    {
+        return false;
+    }
+
+    size_t topic_length = strlen(topic);
+    int alias = findAlias(topic);
+    bool send_topic = (alias == 0);
+
+    // Assign a new alias while the broker and our table allow it
+    uint16_t alias_limit = min((uint16_t)MQTT5_MAX_TOPIC_ALIASES, server_alias_maximum);
+    if (alias == 0 && alias_count < alias_limit && topic_length < MQTT5_MAX_TOPIC_LENGTH)
+    {
+        strcpy(alias_topics[alias_count], topic);
+        alias = ++alias_count;
+    }
+
+    bool expires = message_expiry > 0 && !retained;
+    uint8_t properties_length = (alias ? 3 : 0) + (expires ? 5 : 0);
+    size_t packet_length = 2 + (send_topic ? topic_length : 0) + 1 + properties_length + length;
+
+    if (MQTT5_HEADER_SPACE + packet_length > buffer_size)
+    {
+        return false;
+    }
+
+    size_t pos = MQTT5_HEADER_SPACE;
+    if (send_topic)
+    {
+        pos = put_string(buffer, pos, topic);
+    }
+    else
+    {
+        pos = put_u16(buffer, pos, 0); // Empty topic: the alias identifies it
+    }
+
+    buffer[pos++] = properties_length;
+    if (expires)
+    {
+        buffer[pos++] = MQTT5_PROP_MESSAGE_EXPIRY;
+        pos = put_u32(buffer, pos, message_expiry);
+    }
+    if (alias)
+    {
+        buffer[pos++] = MQTT5_PROP_TOPIC_ALIAS;
+        pos = put_u16(buffer, pos, alias);
+    }
+
+    memcpy(buffer + pos, payload, length);
+
+    publish_count++;
+    return writePacket(MQTT5_PUBLISH | (retained ? 1 : 0), packet_length);
+}
+
+// Subscribe to a topic filter at QoS 0 - the SUBACK is handled in loop()
+bool Mqtt5Client::subscribe(const char *topic)
+{
+    if (!connected())
+    {
+        return false;
+    }
+
+    size_t packet_length = 2 + 1 + 2 + strlen(topic) + 1;
+    if (MQTT5_HEADER_SPACE + packet_length > buffer_size)
+    {
+        return false;
+    }
+
+    size_t pos = put_u16(buffer, MQTT5_HEADER_SPACE, next_packet_id);
+    next_packet_id = next_packet_id == 0xFFFF ? 1 : next_packet_id + 1;
+    buffer[pos++] = 0; // No properties
+    pos = put_string(buffer, pos, topic);
+    buffer[pos++] = 0x00; // Subscription options: QoS 0
+
+    return writePacket(MQTT5_SUBSCRIBE, packet_length);
+}
@@ -0,0 +1,94 @@
+/*
+ * MQTT 5 Client
+ *
+ * Minimal MQTT 5.0 client (QoS 0) with the same interface as the parts
+ * of PubSubClient used by mqtt.cpp, so either can sit behind the mqtt_*
+ * API. Topic aliases let steady-state publishes carry a 2-byte alias
+ * instead of the full topic string.
+ */
+
+#ifndef MQTT5_CLIENT_H
+#define MQTT5_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Client limits
+#define MQTT5_MAX_TOPIC_ALIASES 16  // Aliases we assign for outgoing topics
+#define MQTT5_MAX_TOPIC_LENGTH 48   // Longest topic that can be aliased
+#define MQTT5_RECEIVE_MAXIMUM 64    // QoS 1/2 messages the broker may have in flight to us
+#define MQTT5_DEFAULT_BUFFER_SIZE 256
+
+// Connection states (same values as PubSubClient)
+#define MQTT5_CONNECTION_TIMEOUT -4
+#define MQTT5_CONNECTION_LOST -3
+#define MQTT5_CONNECT_FAILED -2
+#define MQTT5_DISCONNECTED -1
+#define MQTT5_CONNECTED 0
+
+// Called for every message received on a subscribed topic (same signature as PubSubClient)
+typedef void (*mqtt5_callback_t)(char *topic, uint8_t *payload, unsigned int length);
+
+class Mqtt5Client
+{
+public:
+    Mqtt5Client(Client &client);
+    ~Mqtt5Client();
+
+    Mqtt5Client &setServer(const char *host, uint16_t port);
+    Mqtt5Client &setKeepAlive(uint16_t seconds);
+    Mqtt5Client &setSocketTimeout(uint16_t seconds);
+    Mqtt5Client &setMessageExpiry(uint32_t seconds); // 0 = messages never expire
+    Mqtt5Client &setCallback(mqtt5_callback_t callback);
+    bool setBufferSize(uint16_t size);
+
+    bool connect(const char *id);
+    bool connect(const char *id, const char *user, const char *pass);
+    void disconnect();
+    bool connected();
+    int state() { return connection_state; }
+    bool loop();
+
+    bool publish(const char *topic, const char *payload, bool retained = false);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained = false);
+    bool subscribe(const char *topic); // QoS 0
+
+    // Statistics for comparing against MQTT 3.1.1
+    uint32_t getBytesSent() { return bytes_sent; }
+    uint32_t getPublishCount() { return publish_count; }
+
+private:
+    bool readByte(uint8_t *value);
+    bool readPacket(uint8_t *type, uint32_t *length);
+    bool writePacket(uint8_t header, size_t length);
+    bool parseConnack(uint32_t length);
+    void handlePublish(uint8_t flags, uint32_t length);
+    int findAlias(const char *topic);
+
+    Client *client;
+    const char *host;
+    uint16_t port;
+    uint16_t keep_alive;
+    uint16_t socket_timeout;
+    uint32_t message_expiry;
+    mqtt5_callback_t callback;
+    uint16_t next_packet_id;
+
+    uint8_t *buffer;
+    uint16_t buffer_size;
+
+    int connection_state;
+    unsigned long last_out_activity;
+    unsigned long last_in_activity;
+    bool ping_outstanding;
+
+    // Outgoing topic aliases, valid for the current connection only
+    char alias_topics[MQTT5_MAX_TOPIC_ALIASES][MQTT5_MAX_TOPIC_LENGTH];
+    uint8_t alias_count;
+    uint16_t server_alias_maximum;
+
+    uint32_t bytes_sent;
+    uint32_t publish_count;
+};
+
+#endif // MQTT5_CLIENT_H
@@ -0,0 +1,16 @@
+/*
+ * CA certificate for the MQTT TLS connection
+ *
+ * Paste the PEM certificate of the CA that signed your broker's
+ * certificate (e.g. the mosquitto `cafile`). Without one the connection
+ * is refused, unless MQTT_TLS_INSECURE in mqtt.h allows encrypting
+ * without verifying the broker - only for testing.
+ */
+
+#ifndef MQTT_CA_CERT_H
+#define MQTT_CA_CERT_H
+
+static const char mqtt_ca_cert[] =
+    "";
+
+#endif // MQTT_CA_CERT_H
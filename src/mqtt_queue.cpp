@@ -0,0 +1,270 @@
+#include "mqtt_queue.h"
+#include <LittleFS.h>
+
+// RAM ring buffer (oldest sample at ram_head)
+static mqtt_sample_t ram_queue[MQTT_QUEUE_RAM_SAMPLES];
+static uint16_t ram_head = 0;
+static uint16_t ram_count = 0;
+
+// Flash spill file - samples are appended at the end and read from spill_read_index
+static bool spill_available = false;
+static uint32_t spill_write_index = 0;
+static uint32_t spill_read_index = 0;
+static uint32_t spill_previous_boot_end = 0; // Entries before this index were written before the last reset
+
+// Read-ahead cache for spilled samples, avoids a flash read per sample
+#define SPILL_CACHE_SAMPLES 8
+static mqtt_sample_t spill_cache[SPILL_CACHE_SAMPLES];
+static uint8_t spill_cache_pos = 0;
+static uint8_t spill_cache_count = 0;
+
+// Metrics
+static mqtt_queue_stats_t queue_stats = {};
+static unsigned long replay_window_start = 0;
+static uint32_t replay_window_count = 0;
+
+// Rewrite the spill file with only its first count samples
+static bool spill_truncate(uint32_t count)
+{
+    File in = LittleFS.open(MQTT_QUEUE_SPILL_FILE, FILE_READ);
+    File out = LittleFS.open(MQTT_QUEUE_SPILL_TEMP, FILE_WRITE);
+    bool ok = in && out;
+
+    // Copy through the read-ahead cache, which is not in use yet
+    for (uint32_t copied = 0; ok && copied < count;)
+    {
+        uint32_t chunk = min(count - copied, (uint32_t)SPILL_CACHE_SAMPLES);
+        size_t bytes = chunk * sizeof(mqtt_sample_t);
+        ok = in.read((uint8_t *)spill_cache, bytes) == bytes && out.write((const uint8_t *)spill_cache, bytes) == bytes;
+        copied += chunk;
+    }
+
+    if (in)
+    {
+        in.close();
+    }
+    if (out)
+    {
+        out.close();
+    }
+
+    ok = ok && LittleFS.remove(MQTT_QUEUE_SPILL_FILE) && LittleFS.rename(MQTT_QUEUE_SPILL_TEMP, MQTT_QUEUE_SPILL_FILE);
+    if (!ok)
+    {
+        LittleFS.remove(MQTT_QUEUE_SPILL_TEMP);
+    }
+    return ok;
+}
+
+// Pick up samples spilled before a reset or brownout - they are replayed first
+static void spill_recover()
+{
+    File file = LittleFS.open(MQTT_QUEUE_SPILL_FILE, FILE_READ);
+    if (!file)
+    {
+        return;
+    }
+    size_t size = file.size();
+    file.close();
+
+    // A brownout during a spill can leave a partial sample at the end
+    uint32_t count = min((uint32_t)(size / sizeof(mqtt_sample_t)), (uint32_t)MQTT_QUEUE_SPILL_MAX_SAMPLES);
+    if (count * sizeof(mqtt_sample_t) != size && !spill_truncate(count))
+    {
+        Serial.println("MQTT queue: damaged spill file discarded");
+        LittleFS.remove(MQTT_QUEUE_SPILL_FILE);
+        return;
+    }
+    if (count == 0)
+    {
+        LittleFS.remove(MQTT_QUEUE_SPILL_FILE);
+        return;
+    }
+
+    spill_write_index = count;
+    spill_previous_boot_end = count;
+    queue_stats.recovered = count;
+    Serial.print("MQTT queue: ");
+    Serial.print(count);
+    Serial.println(" samples from before the reset");
+}
+
+// Initialize offline queue and flash storage
+void mqtt_queue_init()
+{
+    // Format on first use
+    spill_available = LittleFS.begin(true);
+    if (spill_available)
+    {
+        LittleFS.remove(MQTT_QUEUE_SPILL_TEMP);
+        spill_recover();
+    }
+    else
+    {
+        Serial.println("MQTT queue: flash unavailable, RAM only");
+    }
+}
+
+// Move the oldest RAM samples to flash, returns false if there is no room
+static bool spill_to_flash()
+{
+    if (!spill_available || spill_write_index + MQTT_QUEUE_SPILL_SAMPLES > MQTT_QUEUE_SPILL_MAX_SAMPLES)
+    {
+        return false;
+    }
+
+    // Collect oldest samples in order, unwrapping the ring
+    mqtt_sample_t chunk[MQTT_QUEUE_SPILL_SAMPLES];
+    for (int i = 0; i < MQTT_QUEUE_SPILL_SAMPLES; i++)
+    {
+        chunk[i] = ram_queue[(ram_head + i) % MQTT_QUEUE_RAM_SAMPLES];
+    }
+
+    File file = LittleFS.open(MQTT_QUEUE_SPILL_FILE, FILE_APPEND);
+    if (!file)
+    {
+        return false;
+    }
+    size_t written = file.write((const uint8_t *)chunk, sizeof(chunk));
+    file.close();
+
+    if (written != sizeof(chunk))
+    {
+        return false;
+    }
+
+    ram_head = (ram_head + MQTT_QUEUE_SPILL_SAMPLES) % MQTT_QUEUE_RAM_SAMPLES;
+    ram_count -= MQTT_QUEUE_SPILL_SAMPLES;
+    spill_write_index += MQTT_QUEUE_SPILL_SAMPLES;
+    queue_stats.spilled_total += MQTT_QUEUE_SPILL_SAMPLES;
+    return true;
+}
+
+// Queue a sample with its original timestamp
+void mqtt_queue_push_sample(const mqtt_sample_t *sample)
+{
+    if (ram_count == MQTT_QUEUE_RAM_SAMPLES && !spill_to_flash())
+    {
+        // Queue full - drop the oldest RAM sample
+        ram_head = (ram_head + 1) % MQTT_QUEUE_RAM_SAMPLES;
+        ram_count--;
+        queue_stats.dropped_total++;
+    }
+
+    ram_queue[(ram_head + ram_count) % MQTT_QUEUE_RAM_SAMPLES] = *sample;
+    ram_count++;
+    queue_stats.queued_total++;
+}
+
+// Refill the read-ahead cache from the spill file
+static bool load_spill_cache()
+{
+    uint32_t pending = spill_write_index - spill_read_index;
+    uint8_t count = pending < SPILL_CACHE_SAMPLES ? pending : SPILL_CACHE_SAMPLES;
+
+    File file = LittleFS.open(MQTT_QUEUE_SPILL_FILE, FILE_READ);
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.seek(spill_read_index * sizeof(mqtt_sample_t)) &&
+              file.read((uint8_t *)spill_cache, count * sizeof(mqtt_sample_t)) == count * sizeof(mqtt_sample_t);
+    file.close();
+
+    spill_cache_pos = 0;
+    spill_cache_count = ok ? count : 0;
+    return ok;
+}
+
+// Get the oldest queued sample without removing it - previous_boot is set if its timestamp is from before the reset
+bool mqtt_queue_peek(mqtt_sample_t *sample, bool *previous_boot)
+{
+    *previous_boot = false;
+    if (spill_read_index < spill_write_index)
+    {
+        if (spill_cache_pos >= spill_cache_count && !load_spill_cache())
+        {
+            // Spill file unreadable - discard it and continue from RAM
+            queue_stats.dropped_total += spill_write_index - spill_read_index;
+            LittleFS.remove(MQTT_QUEUE_SPILL_FILE);
+            spill_read_index = spill_write_index = 0;
+            spill_previous_boot_end = 0;
+        }
+        else
+        {
+            *sample = spill_cache[spill_cache_pos];
+            *previous_boot = spill_read_index < spill_previous_boot_end;
+            return true;
+        }
+    }
+
+    if (ram_count == 0)
+    {
+        return false;
+    }
+
+    *sample = ram_queue[ram_head];
+    return true;
+}
+
+// Remove the oldest queued sample
+void mqtt_queue_pop()
+{
+    if (spill_read_index < spill_write_index)
+    {
+        spill_cache_pos++;
+        spill_read_index++;
+
+        // Spill file fully replayed - start over with an empty file
+        if (spill_read_index == spill_write_index)
+        {
+            LittleFS.remove(MQTT_QUEUE_SPILL_FILE);
+            spill_read_index = spill_write_index = 0;
+            spill_cache_pos = spill_cache_count = 0;
+            spill_previous_boot_end = 0;
+        }
+        return;
+    }
+
+    if (ram_count > 0)
+    {
+        ram_head = (ram_head + 1) % MQTT_QUEUE_RAM_SAMPLES;
+        ram_count--;
+    }
+}
+
+// Check if any samples are waiting
+bool mqtt_queue_is_empty()
+{
+    return ram_count == 0 && spill_read_index == spill_write_index;
+}
+
+// Record replayed samples for the throughput metric
+void mqtt_queue_note_replayed(uint32_t count)
+{
+    unsigned long now = millis();
+
+    queue_stats.replayed_total += count;
+    replay_window_count += count;
+
+    if (now - replay_window_start >= 1000)
+    {
+        queue_stats.replay_rate = replay_window_count * 1000 / (now - replay_window_start);
+        replay_window_start = now;
+        replay_window_count = 0;
+    }
+}
+
+// Get queue metrics
+void get_mqtt_queue_stats(mqtt_queue_stats_t *stats)
+{
+    *stats = queue_stats;
+    stats->spilled_depth = spill_write_index - spill_read_index;
+    stats->depth = stats->spilled_depth + ram_count;
+
+    // Throughput decays to zero once replay stops
+    if (millis() - replay_window_start > 2000)
+    {
+        stats->replay_rate = 0;
+    }
+}
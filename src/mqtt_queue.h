@@ -0,0 +1,59 @@
+/*
+ * MQTT Offline Queue for NMEA0183 Level Sensor
+ *
+ * Buffers timestamped samples while the MQTT broker is unreachable and
+ * replays them in order once the connection is back. Samples are held in
+ * a RAM ring buffer; when it fills up, the oldest samples are spilled to
+ * a file in flash. Replay is rate limited so live data is not starved.
+ * The spill file survives a reset or brownout and is replayed after the
+ * next boot; those samples carry timestamps from the previous boot's
+ * clock. Samples already replayed when the reset hit may be sent again.
+ */
+
+#ifndef MQTT_QUEUE_H
+#define MQTT_QUEUE_H
+
+#include <Arduino.h>
+
+// Queue configuration
+#define MQTT_QUEUE_RAM_SAMPLES 64            // Samples held in RAM
+#define MQTT_QUEUE_SPILL_SAMPLES 32          // Samples moved to flash per spill
+#define MQTT_QUEUE_SPILL_MAX_SAMPLES 4096    // Flash capacity (8 bytes per sample)
+#define MQTT_QUEUE_SPILL_FILE "/mqtt_queue.bin"
+#define MQTT_QUEUE_SPILL_TEMP "/mqtt_queue.tmp" // Used while repairing a spill file cut short by a brownout
+
+// Replay rate limiting
+#define MQTT_REPLAY_INTERVAL 250 // ms between replay bursts
+#define MQTT_REPLAY_BURST 4      // Samples published per burst (16 samples/s)
+
+// Buffered sample
+struct mqtt_sample_t
+{
+    uint32_t timestamp; // millis() when the sample was taken
+    int16_t height_mm;
+    int16_t level_percent;
+};
+
+// Queue metrics
+struct mqtt_queue_stats_t
+{
+    uint32_t depth;           // Samples waiting (RAM + flash)
+    uint32_t spilled_depth;   // Samples waiting in flash
+    uint32_t queued_total;    // Samples queued since boot
+    uint32_t spilled_total;   // Samples written to flash since boot
+    uint32_t recovered;       // Samples found in flash at boot, from before the reset
+    uint32_t replayed_total;  // Samples replayed since boot
+    uint32_t dropped_total;   // Samples lost because the queue was full
+    uint32_t replay_rate;     // Samples replayed per second (last second)
+};
+
+// Function declarations
+void mqtt_queue_init();
+void mqtt_queue_push_sample(const mqtt_sample_t *sample);
+bool mqtt_queue_peek(mqtt_sample_t *sample, bool *previous_boot);
+void mqtt_queue_pop();
+bool mqtt_queue_is_empty();
+void mqtt_queue_note_replayed(uint32_t count);
+void get_mqtt_queue_stats(mqtt_queue_stats_t *stats);
+
+#endif // MQTT_QUEUE_H
@@ -0,0 +1,212 @@
+#include "n2k.h"
+#include "n2k_can.h"
+#include <string.h>
+
+// PGNs handled by this node
+#define PGN_ISO_REQUEST 59904UL
+#define PGN_ISO_ADDRESS_CLAIM 60928UL
+#define PGN_FLUID_LEVEL 127505UL
+
+// Special addresses
+#define N2K_ADDRESS_GLOBAL 255
+#define N2K_ADDRESS_NULL 254
+#define N2K_ADDRESS_MAX 251
+
+// Precomputed CAN frame, only the changing bytes are patched before sending
+struct n2k_frame_t
+{
+    uint32_t id;
+    uint8_t data[8];
+};
+
+// Node state
+static bool n2k_initialized = false;
+static uint8_t source_address = N2K_PREFERRED_ADDRESS;
+static bool address_claimed = false;
+static uint32_t claim_time = 0;
+static uint32_t last_fluid_level_sent = 0;
+static uint64_t device_name = 0;
+
+// Frame templates
+static n2k_frame_t claim_frame;
+static n2k_frame_t fluid_level_frame;
+
+// Build a 29-bit CAN identifier from priority, PGN, destination and source
+static uint32_t build_can_id(uint8_t priority, uint32_t pgn, uint8_t destination, uint8_t source)
+{
+    uint8_t pdu_format = (pgn >> 8) & 0xFF;
+    if (pdu_format < 240)
+    {
+        pgn = (pgn & 0x3FF00) | destination; // PDU1: PS field carries the destination
+    }
+    return ((uint32_t)(priority & 0x7) << 26) | (pgn << 8) | source;
+}
+
+// Extract the PGN from a received CAN identifier
+static uint32_t parse_pgn(uint32_t id)
+{
+    uint32_t pgn = (id >> 8) & 0x3FFFF;
+    if (((pgn >> 8) & 0xFF) < 240)
+    {
+        pgn &= 0x3FF00; // PDU1: strip the destination address
+    }
+    return pgn;
+}
+
+// Build the 64-bit ISO NAME used in address claiming
+static uint64_t build_name(uint32_t unique_id)
+{
+    uint64_t name = 0;
+    name |= (uint64_t)(unique_id & 0x1FFFFF);
+    name |= (uint64_t)(N2K_MANUFACTURER_CODE & 0x7FF) << 21;
+    name |= (uint64_t)(N2K_DEVICE_FUNCTION & 0xFF) << 40;
+    name |= (uint64_t)(N2K_DEVICE_CLASS & 0x7F) << 49;
+    name |= (uint64_t)(N2K_INDUSTRY_GROUP & 0x7) << 60;
+    name |= (uint64_t)1 << 63; // Arbitrary address capable
+    return name;
+}
+
+// Update frame identifiers after the source address changed
+static void update_frame_templates()
+{
+    claim_frame.id = build_can_id(6, PGN_ISO_ADDRESS_CLAIM, N2K_ADDRESS_GLOBAL, source_address);
+    fluid_level_frame.id = build_can_id(6, PGN_FLUID_LEVEL, N2K_ADDRESS_GLOBAL, source_address);
+}
+
+// Send our address claim
+static void send_address_claim()
+{
+    update_frame_templates();
+    n2k_can_send(claim_frame.id, claim_frame.data, 8);
+    claim_time = n2k_can_millis();
+    address_claimed = (source_address != N2K_ADDRESS_NULL);
+}
+
+// Handle an address claim from another node
+static void handle_address_claim(uint8_t sender, const uint8_t *data)
+{
+    if (sender != source_address)
+    {
+        return;
+    }
+
+    uint64_t other_name = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        other_name = (other_name << 8) | data[i];
+    }
+
+    if (device_name < other_name)
+    {
+        send_address_claim(); // We win, defend our address
+        return;
+    }
+
+    // We lose, move on to the next address
+    uint8_t next = (source_address >= N2K_ADDRESS_MAX) ? 0 : source_address + 1;
+    source_address = (next == N2K_PREFERRED_ADDRESS) ? N2K_ADDRESS_NULL : next;
+    send_address_claim();
+}
+
+// Initialize NMEA 2000 node and start address claiming
+bool n2k_init()
+{
+    if (!n2k_can_open())
+    {
+        return false;
+    }
+
+    device_name = build_name(n2k_can_unique_id());
+    for (int i = 0; i < 8; i++)
+    {
+        claim_frame.data[i] = (device_name >> (8 * i)) & 0xFF;
+    }
+
+    // Fluid level template: instance/type, level (patched), capacity, reserved
+    uint32_t capacity = (uint32_t)(N2K_TANK_CAPACITY_L * 10.0f); // 0.1 L resolution
+    fluid_level_frame.data[0] = (N2K_TANK_INSTANCE & 0x0F) | ((N2K_FLUID_TYPE & 0x0F) << 4);
+    fluid_level_frame.data[1] = 0xFF;
+    fluid_level_frame.data[2] = 0x7F;
+    fluid_level_frame.data[3] = capacity & 0xFF;
+    fluid_level_frame.data[4] = (capacity >> 8) & 0xFF;
+    fluid_level_frame.data[5] = (capacity >> 16) & 0xFF;
+    fluid_level_frame.data[6] = (capacity >> 24) & 0xFF;
+    fluid_level_frame.data[7] = 0xFF;
+
+    source_address = N2K_PREFERRED_ADDRESS;
+    send_address_claim();
+
+    n2k_initialized = true;
+    return true;
+}
+
+// NMEA 2000 receive handler - must be called regularly
+void n2k_loop()
+{
+    if (!n2k_initialized)
+    {
+        return;
+    }
+
+    uint32_t id;
+    uint8_t data[8];
+    uint8_t len;
+
+    while (n2k_can_receive(&id, data, &len))
+    {
+        uint32_t pgn = parse_pgn(id);
+        uint8_t sender = id & 0xFF;
+        uint8_t destination = (id >> 8) & 0xFF;
+
+        if (pgn == PGN_ISO_ADDRESS_CLAIM && len == 8)
+        {
+            handle_address_claim(sender, data);
+        }
+        else if (pgn == PGN_ISO_REQUEST && len >= 3 &&
+                 (destination == N2K_ADDRESS_GLOBAL || destination == source_address))
+        {
+            uint32_t requested = data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16);
+            if (requested == PGN_ISO_ADDRESS_CLAIM)
+            {
+                send_address_claim();
+            }
+        }
+    }
+
+    // Keep the level alive on the bus between sensor updates
+    if (is_n2k_address_claimed() && n2k_can_millis() - last_fluid_level_sent > N2K_FLUID_LEVEL_INTERVAL)
+    {
+        n2k_can_send(fluid_level_frame.id, fluid_level_frame.data, 8);
+        last_fluid_level_sent = n2k_can_millis();
+    }
+}
+
+// Send PGN 127505 Fluid Level
+bool n2k_send_fluid_level(float level_percent)
+{
+    if (!is_n2k_address_claimed())
+    {
+        return false;
+    }
+
+    // Level in 0.004 % steps
+    int16_t level = (int16_t)(level_percent * 250.0f);
+    fluid_level_frame.data[1] = level & 0xFF;
+    fluid_level_frame.data[2] = (level >> 8) & 0xFF;
+
+    last_fluid_level_sent = n2k_can_millis();
+    return n2k_can_send(fluid_level_frame.id, fluid_level_frame.data, 8);
+}
+
+// Check if we own a source address and the claim wait has passed
+bool is_n2k_address_claimed()
+{
+    return n2k_initialized && address_claimed &&
+           (n2k_can_millis() - claim_time > N2K_ADDRESS_CLAIM_WAIT);
+}
+
+// Get current NMEA 2000 source address
+uint8_t get_n2k_source_address()
+{
+    return source_address;
+}
@@ -0,0 +1,38 @@
+/*
+ * NMEA 2000 Module for NMEA0183 Level Sensor
+ *
+ * Sends the tank level as PGN 127505 (Fluid Level) on an NMEA 2000
+ * network and takes part in ISO address claiming. The stack only uses
+ * the transport in n2k_can.h, so it can be exercised on a Linux host
+ * against SocketCAN vcan0 as well as on the ESP32 TWAI controller.
+ */
+
+#ifndef N2K_H
+#define N2K_H
+
+#include <stdint.h>
+
+// Device configuration
+#define N2K_PREFERRED_ADDRESS 35  // Source address we try to claim first
+#define N2K_MANUFACTURER_CODE 2046 // Unregistered/experimental manufacturer code
+#define N2K_DEVICE_FUNCTION 150   // Fluid level
+#define N2K_DEVICE_CLASS 75       // Sensor communication interface
+#define N2K_INDUSTRY_GROUP 4      // Marine
+
+// Tank configuration for PGN 127505
+#define N2K_TANK_INSTANCE 0
+#define N2K_FLUID_TYPE 0           // 0 = fuel, 1 = fresh water, 2 = waste water, 5 = black water
+#define N2K_TANK_CAPACITY_L 100.0f // Tank capacity in litres
+
+// Timing
+#define N2K_ADDRESS_CLAIM_WAIT 250 // ms to wait after a claim before transmitting
+#define N2K_FLUID_LEVEL_INTERVAL 2500 // ms between periodic PGN 127505 transmissions
+
+// Function declarations
+bool n2k_init();
+void n2k_loop();
+bool n2k_send_fluid_level(float level_percent);
+bool is_n2k_address_claimed();
+uint8_t get_n2k_source_address();
+
+#endif // N2K_H
@@ -0,0 +1,31 @@
+/*
+ * CAN Transport Interface for the NMEA 2000 Module
+ *
+ * Small hardware abstraction so the NMEA 2000 stack in n2k.cpp runs
+ * unchanged on the ESP32 TWAI controller (n2k_can_twai.cpp) and on a
+ * Linux host against SocketCAN, e.g. vcan0 (n2k_can_socketcan.cpp).
+ * Exactly one backend is compiled in, selected by platform.
+ */
+
+#ifndef N2K_CAN_H
+#define N2K_CAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ESP32 TWAI configuration - pins go to an external CAN transceiver. On the CYD only a few GPIOs reach a
+// header: 27 is on CN1 (next to the sensor's 22) and 35 (input only) on P3. GPIO 4 drives the RGB LED.
+#define N2K_CAN_TX_PIN 27
+#define N2K_CAN_RX_PIN 35
+
+// Linux SocketCAN configuration (override with the N2K_CAN_IFACE environment variable)
+#define N2K_CAN_INTERFACE "vcan0"
+
+// Function declarations - all calls are non-blocking
+bool n2k_can_open();
+bool n2k_can_send(uint32_t id, const uint8_t *data, uint8_t len);
+bool n2k_can_receive(uint32_t *id, uint8_t *data, uint8_t *len);
+uint32_t n2k_can_millis();
+uint32_t n2k_can_unique_id();
+
+#endif // N2K_CAN_H
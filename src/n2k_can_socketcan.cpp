@@ -0,0 +1,143 @@
+/*
+ * Linux SocketCAN backend for the NMEA 2000 CAN transport
+ *
+ * Lets the NMEA 2000 stack run on a host for testing against a virtual bus:
+ *   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+ *   g++ -DN2K_HOST_DEMO -Isrc src/n2k.cpp src/n2k_can_socketcan.cpp -o n2k_host
+ *   ./n2k_host & candump vcan0
+ */
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include "n2k_can.h"
+#include "n2k.h"
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Raw CAN socket
+static int can_socket = -1;
+
+// Open non-blocking raw CAN socket on the configured interface
+bool n2k_can_open()
+{
+    const char *interface_name = getenv("N2K_CAN_IFACE");
+    if (interface_name == NULL)
+    {
+        interface_name = N2K_CAN_INTERFACE;
+    }
+
+    can_socket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (can_socket < 0)
+    {
+        perror("NMEA 2000: socket");
+        return false;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface_name, IFNAMSIZ - 1);
+    if (ioctl(can_socket, SIOCGIFINDEX, &ifr) < 0)
+    {
+        perror("NMEA 2000: interface lookup");
+        close(can_socket);
+        can_socket = -1;
+        return false;
+    }
+
+    struct sockaddr_can address;
+    memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = ifr.ifr_ifindex;
+    if (bind(can_socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        perror("NMEA 2000: bind");
+        close(can_socket);
+        can_socket = -1;
+        return false;
+    }
+
+    fcntl(can_socket, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+// Send one extended frame without waiting
+bool n2k_can_send(uint32_t id, const uint8_t *data, uint8_t len)
+{
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = (id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    frame.can_dlc = len;
+    memcpy(frame.data, data, len);
+
+    return write(can_socket, &frame, sizeof(frame)) == sizeof(frame);
+}
+
+// Fetch one received extended frame, if any
+bool n2k_can_receive(uint32_t *id, uint8_t *data, uint8_t *len)
+{
+    struct can_frame frame;
+
+    while (read(can_socket, &frame, sizeof(frame)) == sizeof(frame))
+    {
+        if (!(frame.can_id & CAN_EFF_FLAG) || (frame.can_id & CAN_RTR_FLAG))
+        {
+            continue; // NMEA 2000 only uses extended data frames
+        }
+
+        *id = frame.can_id & CAN_EFF_MASK;
+        *len = frame.can_dlc;
+        memcpy(data, frame.data, frame.can_dlc);
+        return true;
+    }
+    return false;
+}
+
+// Millisecond clock
+uint32_t n2k_can_millis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+// Unique number for the NAME identity field
+uint32_t n2k_can_unique_id()
+{
+    return (uint32_t)getpid();
+}
+
+#ifdef N2K_HOST_DEMO
+// Host demo: claim an address and send a slowly rising level once per second
+int main()
+{
+    if (!n2k_init())
+    {
+        return 1;
+    }
+
+    float level = 0.0f;
+    uint32_t last_send = 0;
+    for (;;)
+    {
+        n2k_loop();
+        if (n2k_can_millis() - last_send >= 1000 && n2k_send_fluid_level(level))
+        {
+            printf("Sent PGN 127505 from address %u: %.1f %%\n", get_n2k_source_address(), level);
+            last_send = n2k_can_millis();
+            level = (level >= 100.0f) ? 0.0f : level + 1.0f;
+        }
+        usleep(10000);
+    }
+}
+#endif // N2K_HOST_DEMO
+
+#endif // __linux__ && !ARDUINO
@@ -0,0 +1,103 @@
+/*
+ * ESP32 TWAI backend for the NMEA 2000 CAN transport
+ */
+
+#ifdef ESP32
+
+#include "n2k_can.h"
+#include <Arduino.h>
+#include <driver/twai.h>
+
+// Open TWAI controller at the NMEA 2000 bit rate of 250 kbit/s
+bool n2k_can_open()
+{
+    twai_general_config_t general_config = TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)N2K_CAN_TX_PIN, (gpio_num_t)N2K_CAN_RX_PIN, TWAI_MODE_NORMAL);
+    general_config.tx_queue_len = 8;
+    general_config.rx_queue_len = 16;
+    twai_timing_config_t timing_config = TWAI_TIMING_CONFIG_250KBITS();
+    twai_filter_config_t filter_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+
+    if (twai_driver_install(&general_config, &timing_config, &filter_config) != ESP_OK)
+    {
+        Serial.println("NMEA 2000: TWAI driver install failed");
+        return false;
+    }
+
+    if (twai_start() != ESP_OK)
+    {
+        Serial.println("NMEA 2000: TWAI start failed");
+        return false;
+    }
+
+    return true;
+}
+
+// Recover the controller if it went bus-off (e.g. no transceiver or bus attached)
+static void recover_if_bus_off()
+{
+    twai_status_info_t status;
+    if (twai_get_status_info(&status) != ESP_OK)
+    {
+        return;
+    }
+
+    if (status.state == TWAI_STATE_BUS_OFF)
+    {
+        twai_initiate_recovery();
+    }
+    else if (status.state == TWAI_STATE_STOPPED)
+    {
+        twai_start();
+    }
+}
+
+// Queue a frame for transmission without waiting
+bool n2k_can_send(uint32_t id, const uint8_t *data, uint8_t len)
+{
+    twai_message_t message = {};
+    message.extd = 1;
+    message.identifier = id;
+    message.data_length_code = len;
+    memcpy(message.data, data, len);
+
+    if (twai_transmit(&message, 0) != ESP_OK)
+    {
+        recover_if_bus_off();
+        return false;
+    }
+    return true;
+}
+
+// Fetch one received extended frame, if any
+bool n2k_can_receive(uint32_t *id, uint8_t *data, uint8_t *len)
+{
+    twai_message_t message;
+
+    while (twai_receive(&message, 0) == ESP_OK)
+    {
+        if (!message.extd || message.rtr)
+        {
+            continue; // NMEA 2000 only uses extended data frames
+        }
+
+        *id = message.identifier;
+        *len = message.data_length_code;
+        memcpy(data, message.data, message.data_length_code);
+        return true;
+    }
+    return false;
+}
+
+// Millisecond clock
+uint32_t n2k_can_millis()
+{
+    return millis();
+}
+
+// Unique number for the NAME identity field
+uint32_t n2k_can_unique_id()
+{
+    return (uint32_t)ESP.getEfuseMac();
+}
+
+#endif // ESP32
@@ -9,6 +9,9 @@ WiFiUDP Udp;
 // Data string storage
 String XDR1;
 
+// millis() at the first datagram sent since boot, 0 until then
+static uint32_t first_datagram_ms = 0;
+
 // Initialize NMEA/UDP system
 void nmea_init()
 {
@@ -64,6 +67,18 @@ String get_data_string()
     return XDR1;
 }
 
+// Send NMEA data on the serial port (independent of WiFi)
+void send_nmea_serial(const String &nmea_string)
+{
+    if (!NMEA_SERIAL_OUTPUT)
+    {
+        return;
+    }
+
+    Serial.print(nmea_string);
+    Serial.print("\r\n"); // NMEA sentences end with CR LF
+}
+
 // Send NMEA data via UDP broadcast
 void send_nmea_data(String nmea_string)
 {
@@ -95,7 +110,11 @@ void send_nmea_data(String nmea_string)
         size_t bytes_written = Udp.write((uint8_t *)XDR, strlen(XDR));
         if (Udp.endPacket())
         {
-            // Successful transmission - no verbose logging needed
+            // Successful transmission - keep boot-to-first-datagram for the power statistics
+            if (first_datagram_ms == 0)
+            {
+                first_datagram_ms = millis();
+            }
         }
         else
         {
@@ -106,4 +125,10 @@ void send_nmea_data(String nmea_string)
     {
         Serial.println("UDP send failed: beginPacket() failed");
     }
-}
\ No newline at end of file
+}
+
+// Time from boot to the first NMEA datagram in ms, 0 if none was sent yet
+uint32_t get_nmea_first_datagram_ms()
+{
+    return first_datagram_ms;
+}
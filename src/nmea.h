@@ -5,13 +5,19 @@
 #include <WiFi.h>
 #include <WiFiUdp.h>
 
+// Serial output - sentences on the USB serial port (115200 baud) for wired plotters and logging.
+// Off by default: the debug log shares that port, so a plotter would also see non-NMEA lines.
+#define NMEA_SERIAL_OUTPUT 0
+
 // Function declarations
 void nmea_init();
 String create_nmea_xdr(String value);
 int calculate_checksum(String nmea_string);
 void send_nmea_data(String nmea_string);
+void send_nmea_serial(const String &nmea_string);
 void set_data_string(String nmea_data);
 String get_data_string();
+uint32_t get_nmea_first_datagram_ms();
 
 // UDP configuration
 extern unsigned int portBroadcast;
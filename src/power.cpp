@@ -0,0 +1,185 @@
+#include "power.h"
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+// Lock bookkeeping - locks may be taken from more than one task
+static SemaphoreHandle_t power_mutex = NULL;
+static uint8_t lock_depth[POWER_LOCK_COUNT];
+static uint8_t locks_held = 0;
+static unsigned long lock_started[POWER_LOCK_COUNT];
+static unsigned long state_started = 0;
+static power_stats_t power_stats = {};
+
+#if CONFIG_PM_ENABLE
+static bool power_enabled = false;
+static esp_pm_lock_handle_t pm_locks[POWER_LOCK_COUNT];
+static const char *pm_lock_names[POWER_LOCK_COUNT] = {"render", "flush", "network"};
+static esp_pm_lock_handle_t awake_lock = NULL; // No light sleep while sensor UART data is expected
+#endif
+
+// Initialize power management
+void power_init()
+{
+    power_mutex = xSemaphoreCreateMutex();
+    state_started = millis();
+
+    if (!POWER_MANAGEMENT)
+    {
+        return;
+    }
+
+#if CONFIG_PM_ENABLE
+    // Let ESP-IDF scale the frequency and light-sleep in the idle task
+    esp_pm_config_esp32_t pm_config;
+    pm_config.max_freq_mhz = POWER_CPU_MAX_MHZ;
+    pm_config.min_freq_mhz = POWER_CPU_MIN_MHZ;
+    pm_config.light_sleep_enable = POWER_LIGHT_SLEEP;
+
+    if (esp_pm_configure(&pm_config) == ESP_OK)
+    {
+        for (int i = 0; i < POWER_LOCK_COUNT; i++)
+        {
+            esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, pm_lock_names[i], &pm_locks[i]);
+        }
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "sensor_rx", &awake_lock);
+        power_stats.scaling = true;
+        power_stats.light_sleep = POWER_LIGHT_SLEEP;
+        power_enabled = true;
+        Serial.println("Power management: ESP-IDF PM enabled");
+        return;
+    }
+    Serial.println("Power management: esp_pm_configure failed");
+#endif
+
+    // No runtime switching without ESP-IDF PM - it changes clocks under the UART and WiFi several times a second
+    setCpuFrequencyMhz(POWER_CPU_MAX_MHZ);
+    Serial.println("Power management: needs CONFIG_PM_ENABLE, CPU stays at full speed");
+}
+
+// Account time spent in the current state before it changes
+static void power_update_residency(unsigned long now)
+{
+    if (locks_held > 0)
+    {
+        power_stats.high_ms += now - state_started;
+    }
+    else
+    {
+        power_stats.low_ms += now - state_started;
+    }
+    state_started = now;
+}
+
+// Raise the CPU frequency for a newly taken lock
+static void power_acquire(power_lock_t lock)
+{
+#if CONFIG_PM_ENABLE
+    if (power_enabled && pm_locks[lock])
+    {
+        unsigned long start = micros();
+        esp_pm_lock_acquire(pm_locks[lock]);
+        uint32_t elapsed = micros() - start;
+        if (elapsed > power_stats.acquire_us_max)
+        {
+            power_stats.acquire_us_max = elapsed;
+        }
+    }
+#endif
+}
+
+// Drop back to the minimum frequency once nothing needs full speed
+static void power_release(power_lock_t lock)
+{
+#if CONFIG_PM_ENABLE
+    if (power_enabled && pm_locks[lock])
+    {
+        esp_pm_lock_release(pm_locks[lock]);
+    }
+#endif
+}
+
+// Run at full speed until the matching power_unlock()
+void power_lock(power_lock_t lock)
+{
+    if (!power_mutex)
+    {
+        return;
+    }
+
+    xSemaphoreTake(power_mutex, portMAX_DELAY);
+
+    if (lock_depth[lock]++ == 0)
+    {
+        unsigned long now = millis();
+        lock_started[lock] = now;
+        power_stats.lock_count[lock]++;
+
+        power_update_residency(now);
+        locks_held++;
+        power_acquire(lock);
+    }
+
+    xSemaphoreGive(power_mutex);
+}
+
+// Release a lock taken with power_lock()
+void power_unlock(power_lock_t lock)
+{
+    if (!power_mutex)
+    {
+        return;
+    }
+
+    xSemaphoreTake(power_mutex, portMAX_DELAY);
+
+    if (lock_depth[lock] > 0 && --lock_depth[lock] == 0)
+    {
+        unsigned long now = millis();
+        power_stats.lock_ms[lock] += now - lock_started[lock];
+
+        power_update_residency(now);
+        locks_held--;
+        power_release(lock);
+    }
+
+    xSemaphoreGive(power_mutex);
+}
+
+// Keep the chip out of light sleep while the sensor is powered - the UART loses the bytes that wake it
+void power_keep_awake(bool awake)
+{
+#if CONFIG_PM_ENABLE
+    static bool held = false;
+    if (!awake_lock || awake == held)
+    {
+        return;
+    }
+
+    held = awake;
+    if (awake)
+    {
+        esp_pm_lock_acquire(awake_lock);
+    }
+    else
+    {
+        esp_pm_lock_release(awake_lock);
+    }
+#endif
+}
+
+// Get residency counters
+void get_power_stats(power_stats_t *stats)
+{
+    if (power_mutex)
+    {
+        xSemaphoreTake(power_mutex, portMAX_DELAY);
+        power_update_residency(millis());
+        *stats = power_stats;
+        xSemaphoreGive(power_mutex);
+    }
+    else
+    {
+        *stats = power_stats;
+    }
+}
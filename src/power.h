@@ -0,0 +1,52 @@
+/*
+ * Power Management Module for NMEA0183 Level Sensor
+ *
+ * Runs the CPU at the lowest frequency between work items. Rendering,
+ * display flushes and network bursts take a lock that raises the CPU to
+ * full speed for their duration. This needs ESP-IDF power management
+ * (CONFIG_PM_ENABLE), which also light-sleeps in the idle task while the
+ * sensor UART is quiet. The stock Arduino core is built without it; the
+ * CPU then stays at POWER_CPU_MAX_MHZ, as switching it by hand several
+ * times a second under WiFi and UART traffic is not safe.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+
+// Power management configuration
+#define POWER_MANAGEMENT 1      // 0 = always run at POWER_CPU_MAX_MHZ
+#define POWER_CPU_MAX_MHZ 240   // While a lock is held
+#define POWER_CPU_MIN_MHZ 80    // Between work items (lowest that keeps WiFi running)
+#define POWER_LIGHT_SLEEP 1     // Light-sleep when idle (needs CONFIG_PM_ENABLE)
+
+// Work items that need full CPU speed
+enum power_lock_t
+{
+    POWER_LOCK_RENDER,  // LVGL timer handler / rendering
+    POWER_LOCK_FLUSH,   // SPI transfer to the display
+    POWER_LOCK_NETWORK, // Network output burst
+    POWER_LOCK_COUNT
+};
+
+// Residency counters
+struct power_stats_t
+{
+    uint32_t high_ms;                   // Time with at least one lock held
+    uint32_t low_ms;                    // Time at the minimum frequency or light-sleeping
+    uint32_t lock_count[POWER_LOCK_COUNT];
+    uint32_t lock_ms[POWER_LOCK_COUNT]; // Time each lock was held
+    bool scaling;                       // Frequency scaling active (ESP-IDF PM)
+    bool light_sleep;                   // Automatic light sleep active
+    uint32_t acquire_us_max;            // Longest time to reach full speed - latency added to a work item
+};
+
+// Function declarations
+void power_init();
+void power_lock(power_lock_t lock);
+void power_unlock(power_lock_t lock);
+void power_keep_awake(bool awake);
+void get_power_stats(power_stats_t *stats);
+
+#endif // POWER_H
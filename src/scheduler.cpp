@@ -0,0 +1,159 @@
+#include "scheduler.h"
+#include <esp_timer.h>
+
+// Scheduled task
+struct scheduler_task_t
+{
+    scheduler_fn_t fn;
+    int64_t period_us;
+    int64_t deadline_us; // Relative to the release
+    uint8_t priority;    // 0 = highest
+    int64_t release_us;  // Next release
+    uint64_t jitter_sum_us;
+    scheduler_stats_t stats;
+};
+
+static scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+static int task_count = 0;
+
+// Add a task, first released immediately - returns its id or -1
+int scheduler_add(const char *name, scheduler_fn_t fn, uint32_t period_ms, uint32_t deadline_ms, uint8_t priority)
+{
+    if (task_count >= SCHEDULER_MAX_TASKS)
+    {
+        Serial.printf("Scheduler: no room for task %s\n", name);
+        return -1;
+    }
+
+    scheduler_task_t *task = &tasks[task_count];
+    task->fn = fn;
+    task->period_us = (int64_t)max(period_ms, (uint32_t)1) * 1000;
+    task->deadline_us = (int64_t)deadline_ms * 1000;
+    task->priority = priority;
+    task->release_us = esp_timer_get_time();
+    task->jitter_sum_us = 0;
+    task->stats = {};
+    task->stats.name = name;
+
+    return task_count++;
+}
+
+// Change a task's period - a shorter period takes effect immediately
+void scheduler_set_period(int id, uint32_t period_ms)
+{
+    if (id < 0 || id >= task_count)
+    {
+        return;
+    }
+
+    scheduler_task_t *task = &tasks[id];
+    int64_t period_us = (int64_t)max(period_ms, (uint32_t)1) * 1000;
+    if (period_us == task->period_us)
+    {
+        return;
+    }
+
+    task->period_us = period_us;
+
+    int64_t now = esp_timer_get_time();
+    if (task->release_us - now > period_us)
+    {
+        task->release_us = now + period_us;
+    }
+}
+
+// Run one task and schedule its next release
+static void scheduler_run_task(scheduler_task_t *task, int64_t now)
+{
+    uint32_t jitter = now - task->release_us;
+
+    task->fn();
+
+    int64_t end = esp_timer_get_time();
+    uint32_t run_time = end - now;
+
+    scheduler_stats_t *stats = &task->stats;
+    stats->runs++;
+    task->jitter_sum_us += jitter;
+    stats->jitter_avg_us = task->jitter_sum_us / stats->runs;
+    if (jitter > stats->jitter_max_us)
+    {
+        stats->jitter_max_us = jitter;
+    }
+    if (run_time > stats->run_max_us)
+    {
+        stats->run_max_us = run_time;
+    }
+    if (end - task->release_us > task->deadline_us)
+    {
+        stats->overruns++;
+    }
+
+    // Next release is one period after this one, not after the work, so the schedule does not drift
+    task->release_us += task->period_us;
+
+    // More than a period behind - skip the missed releases instead of running back to back
+    if (task->release_us <= end)
+    {
+        int64_t missed = (end - task->release_us) / task->period_us + 1;
+        stats->skipped += missed;
+        task->release_us += missed * task->period_us;
+    }
+}
+
+// Run all due tasks, highest priority first - returns ms until the next release
+uint32_t scheduler_run()
+{
+    for (;;)
+    {
+        int64_t now = esp_timer_get_time();
+
+        // Re-evaluated after every task, a higher priority task may have become due meanwhile
+        scheduler_task_t *next = NULL;
+        for (int i = 0; i < task_count; i++)
+        {
+            if (tasks[i].release_us <= now && (!next || tasks[i].priority < next->priority))
+            {
+                next = &tasks[i];
+            }
+        }
+
+        if (!next)
+        {
+            break;
+        }
+
+        scheduler_run_task(next, now);
+    }
+
+    // Sleep until the earliest release, rounded up so the task is due on wake-up
+    int64_t now = esp_timer_get_time();
+    int64_t sleep_us = (int64_t)SCHEDULER_MAX_SLEEP * 1000;
+    for (int i = 0; i < task_count; i++)
+    {
+        if (tasks[i].release_us - now < sleep_us)
+        {
+            sleep_us = tasks[i].release_us - now;
+        }
+    }
+
+    return sleep_us > 0 ? (sleep_us + 999) / 1000 : 0;
+}
+
+// Number of scheduled tasks
+int scheduler_task_count()
+{
+    return task_count;
+}
+
+// Get a task's statistics
+void get_scheduler_stats(int id, scheduler_stats_t *stats)
+{
+    if (id < 0 || id >= task_count)
+    {
+        *stats = {};
+        return;
+    }
+
+    *stats = tasks[id].stats;
+}
@@ -0,0 +1,56 @@
+/*
+ * Task Scheduler Module for NMEA0183 Level Sensor
+ *
+ * Cooperative scheduler for the network task. Each task has a period,
+ * a relative deadline and a priority. Release times advance by exactly
+ * one period, so tasks do not drift with the time spent working, and the
+ * network task sleeps until the earliest next release instead of a fixed
+ * delay. Lateness (jitter), run time and missed deadlines are recorded
+ * per task.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Scheduler configuration
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_MAX_SLEEP 100 // ms the caller sleeps at most, so period changes are picked up
+
+// Network task running the scheduler - on core 0 with the WiFi stack
+#define NETWORK_TASK_CORE 0
+#define NETWORK_TASK_PRIORITY 1
+#define NETWORK_TASK_STACK 8192
+
+// Task periods and deadlines in ms - sample and status periods come from the runtime configuration
+#define SCHEDULER_SAMPLE_DEADLINE 20   // New sensor sample and local outputs
+#define SCHEDULER_PUBLISH_PERIOD 50    // Network outputs for new samples
+#define SCHEDULER_MQTT_PERIOD 50       // MQTT and Signal K housekeeping
+#define SCHEDULER_N2K_PERIOD 50        // NMEA 2000 bus housekeeping
+#define SCHEDULER_WIFI_PERIOD 250      // WiFi supervision and status bar
+#define SCHEDULER_STATUS_DEADLINE 1000 // Status publish
+
+// Task function
+typedef void (*scheduler_fn_t)();
+
+// Per-task statistics since boot
+struct scheduler_stats_t
+{
+    const char *name;
+    uint32_t runs;
+    uint32_t jitter_avg_us; // Start time after release
+    uint32_t jitter_max_us;
+    uint32_t run_max_us;
+    uint32_t overruns;      // Finished after the deadline
+    uint32_t skipped;       // Releases missed because the task was more than a period late
+};
+
+// Function declarations
+int scheduler_add(const char *name, scheduler_fn_t fn, uint32_t period_ms, uint32_t deadline_ms, uint8_t priority);
+void scheduler_set_period(int id, uint32_t period_ms);
+uint32_t scheduler_run();
+int scheduler_task_count();
+void get_scheduler_stats(int id, scheduler_stats_t *stats);
+
+#endif // SCHEDULER_H
@@ -1,66 +1,243 @@
 #include "sensor.h"
+#include "config.h"
+#include "power.h"
+#include "seqlock.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 // Sensor configuration
-const byte txPin = 27;          // tx of the ESP32 to rx of the sensor
-const byte rxPin = 22;          // rx of the ESP32 to tx of the sensor
+const int8_t txPin = -1;        // Not connected - the DS1603L only transmits (GPIO 27 carries NMEA 2000 CAN TX)
+const int8_t rxPin = 22;        // rx of the ESP32 to tx of the sensor (CN1)
 HardwareSerial sensorSerial(2); // Use Serial2 on ESP32
 
 // Sensor instance
 DS1603L sensor(sensorSerial);
 
-// Variables for sensor readings
-int height = 0;
-String Fuell = "0";
-bool sensor_initialized = false;
-bool new_data_available = false;
+// Sensor state - only used by the sensor task
+static bool sensor_initialized = false;
 
-// Moving average filter for 10 readings
-movingAvg filter(10);
+// Latest sample behind a seqlock - the sensor task is the single writer
+static_assert(sizeof(sensor_snapshot_t) % 4 == 0 && sizeof(sensor_snapshot_t) <= SEQLOCK_MAX_WORDS * 4,
+              "sensor_snapshot_t must fit the seqlock words");
+static seqlock_t snapshot_lock = {};
+static sensor_snapshot_t next_snapshot; // Writer's working copy
+
+// Snapshot access counters
+static uint32_t snapshot_writes = 0;
+static std::atomic<uint32_t> snapshot_reads(0);
+static std::atomic<uint32_t> snapshot_retries(0);
+static std::atomic<uint32_t> snapshot_torn(0);
+
+// Moving average filter - window size follows the runtime configuration.
+// Kept in RTC memory so each wake from deep sleep continues the average.
+RTC_DATA_ATTR static int filter_samples[CONFIG_MAX_FILTER];
+RTC_DATA_ATTR static uint32_t filter_window = 0;
+RTC_DATA_ATTR static uint32_t filter_count = 0;
+RTC_DATA_ATTR static uint32_t filter_next = 0;
+RTC_DATA_ATTR static long filter_sum = 0;
+RTC_DATA_ATTR static int filter_average = 0;
 
 // Timing variables
-const unsigned long Timeout_RX = 5000; // 5 second timeout
-unsigned long Timer_RX = 0;
+static unsigned long Timer_RX = 0;
+
+// Reset the moving average filter to a new window size
+static void filter_reset(uint32_t window)
+{
+    filter_window = window;
+    filter_count = 0;
+    filter_next = 0;
+    filter_sum = 0;
+}
+
+// Add a reading to the moving average filter and return the new average
+static int filter_reading(int value)
+{
+    if (filter_count == filter_window)
+    {
+        filter_sum -= filter_samples[filter_next];
+    }
+    else
+    {
+        filter_count++;
+    }
+
+    filter_samples[filter_next] = value;
+    filter_sum += value;
+    filter_next = (filter_next + 1) % filter_window;
+
+    filter_average = (filter_sum + (long)filter_count / 2) / (long)filter_count;
+    return filter_average;
+}
+
+// Consistency value over the snapshot fields
+static uint32_t snapshot_check(const sensor_snapshot_t *data)
+{
+    uint32_t check = data->sample * 2654435761UL;
+    check ^= (uint32_t)data->height_mm * 40503UL;
+    check ^= (uint32_t)data->level_percent << 16;
+    check ^= data->sensor_ok ? 0x5A5A5A5AUL : 0;
+    check ^= data->timestamp_ms;
+    return check;
+}
+
+// Publish a new snapshot (sensor task only)
+static void snapshot_write(const sensor_snapshot_t *data)
+{
+    sensor_snapshot_t record = *data;
+    record.check = snapshot_check(data);
+
+    seqlock_write(&snapshot_lock, &record, sizeof(record));
+    snapshot_writes++;
+}
+
+// Get the latest sample - lock-free, repeats the copy if the writer was active meanwhile
+void get_sensor_snapshot(sensor_snapshot_t *data)
+{
+    for (int tries = 1; !seqlock_try_read(&snapshot_lock, data, sizeof(*data)); tries++)
+    {
+        snapshot_retries.fetch_add(1, std::memory_order_relaxed);
+
+        // A writer preempted on this core cannot finish while we spin
+        if (tries % SENSOR_SNAPSHOT_SPINS == 0)
+        {
+            vTaskDelay(1);
+        }
+    }
+
+    snapshot_reads.fetch_add(1, std::memory_order_relaxed);
+    if (data->check != snapshot_check(data))
+    {
+        snapshot_torn.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Get snapshot access counters
+void get_sensor_snapshot_stats(sensor_snapshot_stats_t *stats)
+{
+    stats->writes = snapshot_writes;
+    stats->reads = snapshot_reads.load(std::memory_order_relaxed);
+    stats->retries = snapshot_retries.load(std::memory_order_relaxed);
+    stats->torn = snapshot_torn.load(std::memory_order_relaxed);
+}
 
 // Initialize sensor
 void sensor_init()
 {
-    // Initialize sensor serial communication
+    // Power the sensor if its supply is switched
+    if (SENSOR_POWER_PIN >= 0)
+    {
+        pinMode(SENSOR_POWER_PIN, OUTPUT);
+        digitalWrite(SENSOR_POWER_PIN, HIGH);
+    }
+
+    // Initialize sensor serial communication - frames arrive continuously from here on
     sensorSerial.begin(9600, SERIAL_8N1, rxPin, txPin);
+    power_keep_awake(true);
 
-    // Initialize the moving average filter
-    filter.begin();
+    // Initialize the moving average filter - state carried over from deep sleep is kept
+    if (filter_window != get_runtime_config().filter)
+    {
+        filter_reset(get_runtime_config().filter);
+    }
+}
+
+// Switch the sensor supply off (before deep sleep)
+void sensor_power_off()
+{
+    if (SENSOR_POWER_PIN >= 0)
+    {
+        digitalWrite(SENSOR_POWER_PIN, LOW);
+    }
+    power_keep_awake(false);
 }
 
-// Read sensor and return filtered value
-unsigned int read_sensor()
+// Collect a burst of frames after power-up, returns the number of readings added to the filter.
+// Only frames whose checksum passed during this call count - the status alone may be left over.
+int read_sensor_burst(int frames, unsigned long timeout_ms)
 {
-    static unsigned int reading = 0;
+    int received = 0;
+    unsigned long start = millis();
 
-    if (millis() - Timer_RX > Timeout_RX)
+    while (received < frames && millis() - start < timeout_ms)
+    {
+        // The sensor sends 4-byte frames - process each one as it completes
+        if (sensorSerial.available() < 4)
+        {
+            delay(5);
+            continue;
+        }
+
+        uint32_t valid_before = sensor.getValidFrames();
+        unsigned int reading = sensor.readSensor();
+        if (sensor.getValidFrames() != valid_before)
+        {
+            filter_reading(reading);
+            sensor_initialized = true;
+            received++;
+        }
+    }
+
+    return received;
+}
+
+// Get the current filtered reading without sampling
+int get_filtered_height()
+{
+    return filter_average;
+}
+
+// Poll the sensor and publish a new snapshot when there is a new reading or the status changed (sensor task)
+void sensor_poll()
+{
+    runtime_config_t config = get_runtime_config();
+    bool new_reading = false;
+
+    // Window changed over the command topic - restart averaging with the new size
+    if (config.filter != filter_window)
+    {
+        filter_reset(config.filter);
+    }
+
+    // Poll every loop until the first valid reading so startup isn't delayed, then every sample interval
+    if (!sensor_initialized || millis() - Timer_RX > config.sample_ms)
     {
         Timer_RX = millis();
 
-        reading = uint8_t(sensor.readSensor()); // Call this as often or as little as you want
+        // The status stays SUCCESS for up to 10 s after the last frame and the sensor sends one every 1-2 s,
+        // so only a frame that passed its checksum during this call is fed to the filter
+        uint32_t valid_before = sensor.getValidFrames();
+        unsigned int reading = sensor.readSensor(); // Call this as often or as little as you want
+        bool fresh = sensor.getValidFrames() != valid_before;
 
-        byte sensorStatus = sensor.getStatus(); // Check the status of the sensor
-        switch (sensorStatus)
-        {                                // For possible values see DS1603L.h
-        case DS1603L_NO_SENSOR_DETECTED: // No sensor detected
-            // Sensor not detected, keep trying
-            break;
-        case DS1603L_READING_SUCCESS:  // Latest reading was valid
+        if (fresh)
+        {
             sensor_initialized = true; // Mark sensor as working
-            new_data_available = true; // Mark new data available
-            break;
-        case DS1603L_READING_CHECKSUM_FAIL: // Checksum failed
-            // Still consider sensor as working since we got data
+            new_reading = true;        // Only a fresh frame counts as a new sample for the consumers
+            filter_reading(reading);
+        }
+        else if (sensor.getStatus() == DS1603L_READING_CHECKSUM_FAIL)
+        {
+            // Still consider sensor as working since we got data, but the reading is the last good one
             sensor_initialized = true;
-            new_data_available = true; // Mark new data available (even with checksum fail)
-            break;
         }
     }
 
-    return filter.reading(reading);
+    bool sensor_ok = is_sensor_ok();
+    if (!new_reading && sensor_ok == next_snapshot.sensor_ok)
+    {
+        return;
+    }
+
+    if (new_reading)
+    {
+        next_snapshot.sample++;
+        next_snapshot.height_mm = filter_average;
+        next_snapshot.level_percent = calculate_level(filter_average);
+        next_snapshot.timestamp_ms = millis();
+    }
+    next_snapshot.sensor_ok = sensor_ok;
+    snapshot_write(&next_snapshot);
 }
 
 // Check if sensor is working properly
@@ -91,38 +268,8 @@ void print_sensor_status()
     // Status checking without verbose output
 }
 
-// Calculate level percentage and update global variables
-void calculate_level(int height_mm)
+// Calculate level percentage from the filtered height
+int calculate_level(int height_mm)
 {
-    height = height_mm;
-    int Prozent = (height_mm / 400.00) * 100; // 400 mm as total tank height for testing
-    Fuell = String(Prozent, DEC);
-
-    /* Serial.print("Height[mm]: ");
-     Serial.println(height_mm);
-     Serial.print("Level[%]: ");
-     Serial.println(Prozent);
-     Serial.print("Send: ");
-     Serial.println(Fuell);
-     */
+    return (height_mm / 400.00) * 100; // 400 mm as total tank height for testing
 }
-
-// Get level percentage as string
-String get_level_percent()
-{
-    return Fuell;
-}
-
-// Get raw height reading
-int get_raw_height()
-{
-    return height;
-}
-
-// Check if new sensor data is available and clear the flag
-bool is_new_data_available()
-{
-    bool available = new_data_available;
-    new_data_available = false; // Clear the flag after checking
-    return available;
-}
\ No newline at end of file
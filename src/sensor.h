@@ -4,16 +4,46 @@
 #include <Arduino.h>
 #include "DS1603L.h"
 #include <HardwareSerial.h>
-#include <movingAvg.h>
+
+// Switched sensor supply (duty-cycled mode) - GPIO driving a high-side switch with a
+// pull-down so the sensor stays off during deep sleep; -1 = sensor always powered
+#define SENSOR_POWER_PIN -1
+
+#define SENSOR_TASK_CORE 1        // UART ingest runs next to rendering, away from the WiFi stack
+#define SENSOR_TASK_PRIORITY 3    // Highest application priority on its core
+#define SENSOR_TASK_STACK 4096
+#define SENSOR_SNAPSHOT_SPINS 100 // Read retries before a reader sleeps a tick to let the writer finish
+
+// Latest sample - written only by the sensor task, read by any task without locking
+struct sensor_snapshot_t
+{
+    uint32_t sample;       // Incremented once per frame that passed its checksum, 0 = none yet
+    int height_mm;
+    int level_percent;
+    bool sensor_ok;
+    uint32_t timestamp_ms; // millis() of the reading
+    uint32_t check;        // Written with the other fields, verifies that a read was not torn
+};
+
+// Snapshot access counters since boot
+struct sensor_snapshot_stats_t
+{
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t retries; // Reads repeated because the writer was active
+    uint32_t torn;    // Reads that returned inconsistent fields - must stay 0
+};
 
 // Function declarations
 void sensor_init();
-unsigned int read_sensor();
+void sensor_poll();
+void get_sensor_snapshot(sensor_snapshot_t *snapshot);
+void get_sensor_snapshot_stats(sensor_snapshot_stats_t *stats);
+int read_sensor_burst(int frames, unsigned long timeout_ms);
+int get_filtered_height();
+void sensor_power_off();
 bool is_sensor_ok();
-void calculate_level(int height_mm);
-String get_level_percent();
-int get_raw_height();
-bool is_new_data_available();
+int calculate_level(int height_mm);
 
 // Sensor status functions
 byte get_sensor_status();
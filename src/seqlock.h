@@ -0,0 +1,73 @@
+/*
+ * Seqlock Module for NMEA0183 Level Sensor
+ *
+ * Single-writer, multi-reader handoff of a small record without locking.
+ * The record is stored as atomic 32-bit words accessed with relaxed
+ * loads and stores, so a reader racing the writer sees a mix of words
+ * but never undefined behaviour; the sequence number (odd while a write
+ * is in progress) tells the reader to discard such a copy and retry.
+ * Header-only and free of Arduino dependencies so it can be tested on
+ * a host (test/host/seqlock_stress.cpp).
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Seqlock configuration
+#define SEQLOCK_MAX_WORDS 8 // Largest record in 32-bit words
+
+struct seqlock_t
+{
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> words[SEQLOCK_MAX_WORDS];
+};
+
+// Publish a record (single writer only) - size must be a multiple of 4 bytes
+static inline void seqlock_write(seqlock_t *lock, const void *data, size_t size)
+{
+    uint32_t words[SEQLOCK_MAX_WORDS];
+    memcpy(words, data, size);
+
+    uint32_t sequence = lock->sequence.load(std::memory_order_relaxed);
+    lock->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < size / 4; i++)
+    {
+        lock->words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    lock->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Copy the record - returns false if a write was in progress or happened meanwhile
+static inline bool seqlock_try_read(seqlock_t *lock, void *data, size_t size)
+{
+    uint32_t before = lock->sequence.load(std::memory_order_acquire);
+    if (before & 1)
+    {
+        return false;
+    }
+
+    uint32_t words[SEQLOCK_MAX_WORDS];
+    for (size_t i = 0; i < size / 4; i++)
+    {
+        words[i] = lock->words[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (lock->sequence.load(std::memory_order_relaxed) != before)
+    {
+        return false;
+    }
+
+    memcpy(data, words, size);
+    return true;
+}
+
+#endif // SEQLOCK_H
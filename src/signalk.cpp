@@ -0,0 +1,138 @@
+#include "signalk.h"
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+
+// Async web server and Signal K WebSocket stream
+AsyncWebServer signalkServer(SIGNALK_PORT);
+AsyncWebSocket signalkSocket(SIGNALK_STREAM_PATH);
+
+// Delta buffer, rebuilt only when the reading changes and shared by all clients
+static char delta_buffer[320];
+static size_t delta_length = 0;
+
+// Last published level for change detection - the delta carries only the level
+static int last_level_percent = -1;
+
+// Clients that connected since the last signalk_loop() - added in the async TCP task
+static uint32_t new_client_ids[SIGNALK_MAX_CLIENTS];
+static int new_client_count = 0;
+static portMUX_TYPE new_client_mux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long last_cleanup = 0;
+
+// Signal K hello message sent to each client on connect
+static const char hello_message[] =
+    "{\"name\":\"NMEA Level Sensor\",\"version\":\"1.0.0\",\"self\":\"vessels.self\",\"roles\":[\"master\",\"main\"]}";
+
+// Handle WebSocket client events (runs in the async TCP task)
+void signalk_on_event(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len)
+{
+    if (type == WS_EVT_CONNECT)
+    {
+        // Refuse clients beyond the limit to keep memory bounded
+        if (server->count() > SIGNALK_MAX_CLIENTS)
+        {
+            client->close(1013, "Too many clients");
+            return;
+        }
+
+        client->text(hello_message, sizeof(hello_message) - 1);
+
+        // The latest delta is sent from signalk_loop(), which owns the delta buffer
+        portENTER_CRITICAL(&new_client_mux);
+        if (new_client_count < SIGNALK_MAX_CLIENTS)
+        {
+            new_client_ids[new_client_count++] = client->id();
+        }
+        portEXIT_CRITICAL(&new_client_mux);
+    }
+}
+
+// Initialize Signal K server
+void signalk_init()
+{
+    signalkSocket.onEvent(signalk_on_event);
+    signalkServer.addHandler(&signalkSocket);
+
+    // Discovery endpoint so Signal K clients can find the stream. The spec requires an absolute
+    // ws:// URL, built per request because the IP address can change on reconnect.
+    signalkServer.on("/signalk", HTTP_GET, [](AsyncWebServerRequest *request)
+                     {
+                         IPAddress ip = WiFi.localIP();
+                         char discovery[160];
+                         snprintf(discovery, sizeof(discovery),
+                                  "{\"endpoints\":{\"v1\":{\"version\":\"1.0.0\","
+                                  "\"signalk-ws\":\"ws://%u.%u.%u.%u:%u" SIGNALK_STREAM_PATH "\"}}}",
+                                  ip[0], ip[1], ip[2], ip[3], SIGNALK_PORT);
+                         request->send(200, "application/json", discovery); });
+
+    signalkServer.begin();
+    Serial.println("Signal K server initialized");
+}
+
+// Signal K housekeeping - must be called regularly
+void signalk_loop()
+{
+    unsigned long now = millis();
+
+    // Drop disconnected clients and enforce the client limit
+    if (now - last_cleanup > SIGNALK_CLEANUP_INTERVAL)
+    {
+        last_cleanup = now;
+        signalkSocket.cleanupClients(SIGNALK_MAX_CLIENTS);
+    }
+
+    // Bring newly connected clients up to date - the others already have this delta
+    uint32_t ids[SIGNALK_MAX_CLIENTS];
+    portENTER_CRITICAL(&new_client_mux);
+    int count = new_client_count;
+    memcpy(ids, new_client_ids, count * sizeof(ids[0]));
+    new_client_count = 0;
+    portEXIT_CRITICAL(&new_client_mux);
+
+    for (int i = 0; i < count && delta_length > 0; i++)
+    {
+        signalkSocket.text(ids[i], delta_buffer, delta_length); // Ignored if the client has gone
+    }
+}
+
+// Build the tank delta into the shared buffer
+static void build_delta(int level_percent)
+{
+    float level_ratio = level_percent / 100.0f;
+    float volume_m3 = level_ratio * SIGNALK_TANK_CAPACITY_M3;
+
+    int len = snprintf(delta_buffer, sizeof(delta_buffer),
+                       "{\"context\":\"vessels.self\",\"updates\":[{\"source\":{\"label\":\"" SIGNALK_SOURCE_LABEL "\"},"
+                       "\"values\":[{\"path\":\"" SIGNALK_TANK_PATH ".currentLevel\",\"value\":%.3f},"
+                       "{\"path\":\"" SIGNALK_TANK_PATH ".currentVolume\",\"value\":%.5f}]}]}",
+                       level_ratio, volume_m3);
+
+    delta_length = (len > 0 && len < (int)sizeof(delta_buffer)) ? len : 0;
+}
+
+// Push a tank delta to all connected clients if the level changed
+void signalk_publish_tank_data(int height_mm, String level_percent)
+{
+    int level = level_percent.toInt();
+
+    if (level == last_level_percent)
+    {
+        return; // The delta would be identical - height changes within a percent are not sent
+    }
+
+    last_level_percent = level;
+    build_delta(level);
+
+    if (delta_length > 0 && signalkSocket.count() > 0)
+    {
+        // Queued per client by the async server - does not block loop()
+        signalkSocket.textAll(delta_buffer, delta_length);
+    }
+}
+
+// Get number of connected Signal K clients
+size_t get_signalk_client_count()
+{
+    return signalkSocket.count();
+}
@@ -0,0 +1,32 @@
+/*
+ * Signal K Module for NMEA0183 Level Sensor
+ *
+ * Serves tank level deltas over a Signal K WebSocket stream so onboard
+ * Signal K servers and apps can subscribe to the sensor directly.
+ * Deltas are only pushed when the level changes; a client that connects
+ * gets the latest delta right away.
+ */
+
+#ifndef SIGNALK_H
+#define SIGNALK_H
+
+#include <Arduino.h>
+
+// Signal K configuration
+#define SIGNALK_PORT 3000                      // Default Signal K server port
+#define SIGNALK_STREAM_PATH "/signalk/v1/stream"
+#define SIGNALK_TANK_PATH "tanks.fuel.0"      // Adjust for other tank types/instances
+#define SIGNALK_TANK_CAPACITY_M3 0.100        // Tank capacity in cubic metres (100 litres)
+#define SIGNALK_SOURCE_LABEL "DS1603L"
+
+// Client limits - the async server keeps a fixed-size queue per client
+#define SIGNALK_MAX_CLIENTS 10
+#define SIGNALK_CLEANUP_INTERVAL 1000 // 1 second between stale client cleanups
+
+// Function declarations
+void signalk_init();
+void signalk_loop();
+void signalk_publish_tank_data(int height_mm, String level_percent);
+size_t get_signalk_client_count();
+
+#endif // SIGNALK_H
@@ -0,0 +1,60 @@
+#include "task_monitor.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Per-task counters - only written by the owning task
+struct monitor_slot_t
+{
+    const char *name;
+    TaskHandle_t handle;
+    volatile int8_t core;
+    volatile uint32_t busy_us; // Wraps after ~71 minutes, only differences are used
+    uint32_t started_us;
+};
+
+static monitor_slot_t slots[MONITOR_TASK_COUNT] = {};
+
+// Reader state for get_task_loads()
+static uint32_t last_busy_us[MONITOR_TASK_COUNT] = {};
+static uint32_t last_sample_us = 0;
+
+// Register the calling task
+void task_monitor_register(monitor_task_t task, const char *name)
+{
+    slots[task].name = name;
+    slots[task].handle = xTaskGetCurrentTaskHandle();
+    slots[task].core = xPortGetCoreID();
+}
+
+// Mark the start of a work item
+void task_monitor_begin(monitor_task_t task)
+{
+    slots[task].started_us = micros();
+}
+
+// Mark the end of a work item
+void task_monitor_end(monitor_task_t task)
+{
+    slots[task].busy_us += micros() - slots[task].started_us;
+}
+
+// Get the load of each task since the previous call
+void get_task_loads(task_load_t loads[MONITOR_TASK_COUNT])
+{
+    uint32_t now = micros();
+    uint32_t elapsed = now - last_sample_us;
+    last_sample_us = now;
+
+    for (int i = 0; i < MONITOR_TASK_COUNT; i++)
+    {
+        monitor_slot_t *slot = &slots[i];
+        uint32_t busy = slot->busy_us;
+
+        loads[i].name = slot->name ? slot->name : "";
+        loads[i].core = slot->handle ? slot->core : -1;
+        loads[i].cpu_permille = elapsed ? (uint32_t)((uint64_t)(busy - last_busy_us[i]) * 1000 / elapsed) : 0;
+        loads[i].stack_free = slot->handle ? uxTaskGetStackHighWaterMark(slot->handle) : 0;
+
+        last_busy_us[i] = busy;
+    }
+}
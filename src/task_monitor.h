@@ -0,0 +1,40 @@
+/*
+ * Task Monitor Module for NMEA0183 Level Sensor
+ *
+ * Per-task CPU accounting for the firmware's FreeRTOS tasks. Each task
+ * marks the start and end of its work; the time in between is counted as
+ * busy. Counters are only written by the task they belong to, so no lock
+ * is needed. Busy time includes preemption by higher priority tasks on
+ * the same core (WiFi stack on core 0), so it is an upper bound.
+ */
+
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <Arduino.h>
+
+// Monitored tasks
+enum monitor_task_t
+{
+    MONITOR_TASK_SENSOR,  // UART ingest and filtering
+    MONITOR_TASK_NETWORK, // UDP, MQTT, Signal K, NMEA 2000 outputs
+    MONITOR_TASK_DISPLAY, // LVGL rendering
+    MONITOR_TASK_COUNT
+};
+
+// Load of one task since the previous get_task_loads() call
+struct task_load_t
+{
+    const char *name;
+    int8_t core;           // -1 until the task has registered
+    uint32_t cpu_permille; // Busy time per 1000
+    uint32_t stack_free;   // Lowest free stack seen (bytes)
+};
+
+// Function declarations
+void task_monitor_register(monitor_task_t task, const char *name);
+void task_monitor_begin(monitor_task_t task);
+void task_monitor_end(monitor_task_t task);
+void get_task_loads(task_load_t loads[MONITOR_TASK_COUNT]);
+
+#endif // TASK_MONITOR_H
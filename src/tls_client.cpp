@@ -0,0 +1,454 @@
+#include "tls_client.h"
+#include <WiFi.h>
+#include <Preferences.h>
+#include <lwip/sockets.h>
+#include <mbedtls/version.h>
+
+// Session fields are private in mbedTLS 3
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define TLS_SESSION_MASTER(session) ((session).MBEDTLS_PRIVATE(master))
+#else
+#define TLS_SESSION_MASTER(session) ((session).master)
+#endif
+
+// Random number generator shared by all connections, seeded once
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context ctr_drbg;
+static bool rng_ready = false;
+
+TlsClient::TlsClient()
+    : contexts_ready(false), is_connected(false), peeked(-1),
+      ca_cert(NULL), insecure(false), server_name(NULL), persist_session(false),
+      session_valid(false), session_loaded(false), handshake_stats()
+{
+    mbedtls_net_init(&net);
+    mbedtls_ssl_session_init(&cached_session);
+}
+
+TlsClient::~TlsClient()
+{
+    stop();
+    mbedtls_ssl_session_free(&cached_session);
+}
+
+void TlsClient::setCACert(const char *pem)
+{
+    ca_cert = pem;
+}
+
+void TlsClient::setInsecure()
+{
+    insecure = true;
+}
+
+void TlsClient::setServerName(const char *name)
+{
+    server_name = name;
+}
+
+void TlsClient::setSessionPersistence(bool enabled)
+{
+    persist_session = enabled;
+}
+
+// Resolve host name and connect
+int TlsClient::connect(const char *host, uint16_t port)
+{
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip))
+    {
+        return 0;
+    }
+
+    if (server_name == NULL)
+    {
+        server_name = host; // Use the host name for SNI and verification
+    }
+    return connect(ip, port);
+}
+
+// Open TCP connection with timeout and run the TLS handshake
+int TlsClient::connect(IPAddress ip, uint16_t port)
+{
+    stop();
+
+    int fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    net.fd = fd;
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = (uint32_t)ip;
+
+    if (lwip_connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0 && errno != EINPROGRESS)
+    {
+        stop();
+        return 0;
+    }
+
+    // Wait for the TCP connection to complete
+    fd_set write_set;
+    FD_ZERO(&write_set);
+    FD_SET(fd, &write_set);
+    struct timeval timeout = {TLS_CONNECT_TIMEOUT / 1000, (TLS_CONNECT_TIMEOUT % 1000) * 1000};
+
+    int socket_error = 0;
+    socklen_t length = sizeof(socket_error);
+    if (lwip_select(fd + 1, NULL, &write_set, NULL, &timeout) <= 0 ||
+        lwip_getsockopt(fd, SOL_SOCKET, SO_ERROR, &socket_error, &length) < 0 || socket_error != 0)
+    {
+        stop();
+        return 0;
+    }
+
+    if (!handshake())
+    {
+        stop();
+        return 0;
+    }
+
+    is_connected = true;
+    return 1;
+}
+
+// Set up mbedTLS and perform the handshake, offering the cached session
+bool TlsClient::handshake()
+{
+    if (!rng_ready)
+    {
+        mbedtls_entropy_init(&entropy);
+        mbedtls_ctr_drbg_init(&ctr_drbg);
+        const char *personalization = "tls_client";
+        if (mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+                                  (const unsigned char *)personalization, strlen(personalization)) != 0)
+        {
+            return false;
+        }
+        rng_ready = true;
+    }
+
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_init(&ca_chain);
+    contexts_ready = true;
+
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0)
+    {
+        return false;
+    }
+
+    if (ca_cert != NULL && ca_cert[0] != '\0')
+    {
+        if (mbedtls_x509_crt_parse(&ca_chain, (const unsigned char *)ca_cert, strlen(ca_cert) + 1) != 0)
+        {
+            Serial.println("TLS: invalid CA certificate");
+            return false;
+        }
+        mbedtls_ssl_conf_ca_chain(&conf, &ca_chain, NULL);
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    }
+    else if (insecure)
+    {
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    }
+    else
+    {
+        Serial.println("TLS: no CA certificate, refusing to connect without verification");
+        return false;
+    }
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0 ||
+        (server_name != NULL && mbedtls_ssl_set_hostname(&ssl, server_name) != 0))
+    {
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    // Offer the cached session - the server decides whether to resume it
+    if (!session_loaded)
+    {
+        loadSession();
+    }
+    if (session_valid)
+    {
+        mbedtls_ssl_set_session(&ssl, &cached_session);
+    }
+
+    unsigned long start = millis();
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
+    {
+        if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+            millis() - start > TLS_HANDSHAKE_TIMEOUT)
+        {
+            Serial.print("TLS handshake failed: -0x");
+            Serial.println(-ret, HEX);
+            handshake_stats.failed_handshakes++;
+            return false;
+        }
+        delay(1);
+    }
+    uint32_t elapsed = millis() - start;
+
+    // A resumed session keeps the master secret of the one we offered. The session ID cannot tell: with
+    // tickets the client sends a fresh random ID and the server echoes it back on resumption too.
+    mbedtls_ssl_session new_session;
+    mbedtls_ssl_session_init(&new_session);
+    mbedtls_ssl_get_session(&ssl, &new_session);
+
+    bool resumed = session_valid &&
+                   memcmp(TLS_SESSION_MASTER(new_session), TLS_SESSION_MASTER(cached_session),
+                          sizeof(TLS_SESSION_MASTER(new_session))) == 0;
+
+    handshake_stats.last_handshake_ms = elapsed;
+    handshake_stats.last_resumed = resumed;
+    if (resumed)
+    {
+        handshake_stats.resumed_handshakes++;
+        uint32_t avg = handshake_stats.avg_resumed_ms;
+        handshake_stats.avg_resumed_ms = avg ? (avg * 7 + elapsed) / 8 : elapsed;
+    }
+    else
+    {
+        handshake_stats.full_handshakes++;
+        uint32_t avg = handshake_stats.avg_full_ms;
+        handshake_stats.avg_full_ms = avg ? (avg * 7 + elapsed) / 8 : elapsed;
+    }
+
+    // Keep the latest session (tickets may be renewed on resumption)
+    mbedtls_ssl_session_free(&cached_session);
+    cached_session = new_session;
+    session_valid = true;
+
+    // Only write flash after a full handshake to limit wear
+    if (!resumed)
+    {
+        saveSession();
+    }
+
+    Serial.print(resumed ? "TLS session resumed in " : "TLS full handshake in ");
+    Serial.print(elapsed);
+    Serial.println(" ms");
+    return true;
+}
+
+// Store the cached session in NVS
+void TlsClient::saveSession()
+{
+    if (!persist_session)
+    {
+        return;
+    }
+
+    static unsigned char serialized[TLS_SESSION_NVS_SIZE];
+    size_t length = 0;
+    if (mbedtls_ssl_session_save(&cached_session, serialized, sizeof(serialized), &length) != 0)
+    {
+        return; // Too large (e.g. includes the peer certificate) - keep it in RAM only
+    }
+
+    Preferences preferences;
+    if (preferences.begin("mqtt_tls", false))
+    {
+        preferences.putBytes("session", serialized, length);
+        preferences.end();
+    }
+}
+
+// Restore a session saved by a previous boot
+void TlsClient::loadSession()
+{
+    session_loaded = true;
+    if (!persist_session)
+    {
+        return;
+    }
+
+    static unsigned char serialized[TLS_SESSION_NVS_SIZE];
+    Preferences preferences;
+    if (!preferences.begin("mqtt_tls", true))
+    {
+        return;
+    }
+    size_t length = preferences.getBytesLength("session");
+    if (length > 0 && length <= sizeof(serialized))
+    {
+        preferences.getBytes("session", serialized, length);
+        session_valid = (mbedtls_ssl_session_load(&cached_session, serialized, length) == 0);
+    }
+    preferences.end();
+
+    if (!session_valid)
+    {
+        mbedtls_ssl_session_free(&cached_session);
+        mbedtls_ssl_session_init(&cached_session);
+    }
+}
+
+// Forget the cached session (RAM and NVS)
+void TlsClient::clearSession()
+{
+    mbedtls_ssl_session_free(&cached_session);
+    mbedtls_ssl_session_init(&cached_session);
+    session_valid = false;
+
+    Preferences preferences;
+    if (preferences.begin("mqtt_tls", false))
+    {
+        preferences.remove("session");
+        preferences.end();
+    }
+}
+
+size_t TlsClient::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+// Write all data, waiting while the socket is busy
+size_t TlsClient::write(const uint8_t *data, size_t size)
+{
+    if (!is_connected)
+    {
+        return 0;
+    }
+
+    size_t sent = 0;
+    unsigned long start = millis();
+    while (sent < size)
+    {
+        int ret = mbedtls_ssl_write(&ssl, data + sent, size - sent);
+        if (ret > 0)
+        {
+            sent += ret;
+        }
+        else if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            if (millis() - start > TLS_IO_TIMEOUT)
+            {
+                break;
+            }
+            delay(1);
+        }
+        else
+        {
+            stop();
+            break;
+        }
+    }
+    return sent;
+}
+
+// Number of decrypted bytes ready to read (processes any pending record)
+int TlsClient::available()
+{
+    if (!is_connected)
+    {
+        return 0;
+    }
+
+    int count = (peeked >= 0) ? 1 : 0;
+    int ret = mbedtls_ssl_read(&ssl, NULL, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+    {
+        stop(); // Closed by peer or fatal error
+        return count;
+    }
+    return count + mbedtls_ssl_get_bytes_avail(&ssl);
+}
+
+int TlsClient::read()
+{
+    uint8_t value;
+    return (read(&value, 1) == 1) ? value : -1;
+}
+
+int TlsClient::read(uint8_t *data, size_t size)
+{
+    size_t count = 0;
+    if (peeked >= 0 && size > 0)
+    {
+        data[count++] = peeked;
+        peeked = -1;
+    }
+
+    if (is_connected && count < size)
+    {
+        int ret = mbedtls_ssl_read(&ssl, data + count, size - count);
+        if (ret > 0)
+        {
+            count += ret;
+        }
+        else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+        {
+            stop();
+        }
+    }
+    return count > 0 ? (int)count : -1;
+}
+
+int TlsClient::peek()
+{
+    if (peeked < 0)
+    {
+        uint8_t value;
+        if (read(&value, 1) == 1)
+        {
+            peeked = value;
+        }
+    }
+    return peeked;
+}
+
+void TlsClient::flush()
+{
+}
+
+// Close the connection and free the mbedTLS contexts (the cached session is kept)
+void TlsClient::stop()
+{
+    if (contexts_ready)
+    {
+        if (is_connected)
+        {
+            mbedtls_ssl_close_notify(&ssl);
+        }
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_config_free(&conf);
+        mbedtls_x509_crt_free(&ca_chain);
+        contexts_ready = false;
+    }
+
+    if (net.fd >= 0)
+    {
+        lwip_close(net.fd);
+        net.fd = -1;
+    }
+
+    is_connected = false;
+    peeked = -1;
+}
+
+uint8_t TlsClient::connected()
+{
+    if (is_connected)
+    {
+        available(); // Detects a closed connection
+    }
+    return is_connected;
+}
+
+int TlsClient::setNoDelay(bool enabled)
+{
+    int flag = enabled;
+    return lwip_setsockopt(net.fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
@@ -0,0 +1,92 @@
+/*
+ * TLS Client with Session Resumption
+ *
+ * Arduino Client over mbedTLS for the MQTT connection. The negotiated
+ * TLS session (session ID or ticket) is cached in RAM, and optionally in
+ * NVS, so reconnects and reboots resume it with an abbreviated handshake
+ * instead of paying for a full key exchange each time.
+ */
+
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+
+// TLS configuration
+#define TLS_CONNECT_TIMEOUT 5000    // ms for TCP connect
+#define TLS_HANDSHAKE_TIMEOUT 10000 // ms for the TLS handshake
+#define TLS_IO_TIMEOUT 5000         // ms to wait when the socket is busy
+#define TLS_SESSION_NVS_SIZE 1024   // Largest serialized session stored in NVS
+
+// Handshake statistics
+struct tls_stats_t
+{
+    uint32_t full_handshakes;
+    uint32_t resumed_handshakes;
+    uint32_t failed_handshakes;
+    uint32_t last_handshake_ms;
+    uint32_t avg_full_ms;    // Running average of full handshakes
+    uint32_t avg_resumed_ms; // Running average of resumed handshakes
+    bool last_resumed;
+};
+
+class TlsClient : public Client
+{
+public:
+    TlsClient();
+    ~TlsClient();
+
+    void setCACert(const char *pem); // Without one the handshake is refused unless setInsecure() was called
+    void setInsecure();              // Encrypt without verifying the server - only for testing
+    void setServerName(const char *name);
+    void setSessionPersistence(bool enabled); // Also keep the session in NVS
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(const char *host, uint16_t port);
+    size_t write(uint8_t value);
+    size_t write(const uint8_t *data, size_t size);
+    int available();
+    int read();
+    int read(uint8_t *data, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+
+    int setNoDelay(bool enabled);
+    void getStats(tls_stats_t *stats) { *stats = handshake_stats; }
+    void clearSession(); // Forget the cached session (RAM and NVS)
+
+private:
+    bool handshake();
+    void saveSession();
+    void loadSession();
+
+    mbedtls_net_context net;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt ca_chain;
+    bool contexts_ready;
+    bool is_connected;
+    int peeked;
+
+    const char *ca_cert;
+    bool insecure;
+    const char *server_name;
+    bool persist_session;
+
+    // Session kept across connections
+    mbedtls_ssl_session cached_session;
+    bool session_valid;
+    bool session_loaded;
+
+    tls_stats_t handshake_stats;
+};
+
+#endif // TLS_CLIENT_H
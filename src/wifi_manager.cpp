@@ -1,4 +1,5 @@
 #include "wifi_manager.h"
+#include "mqtt.h"
 
 // WiFi credentials for AP mode
 const char SSID[30] = "UltrasonicSensor";
@@ -10,6 +11,62 @@ const byte LED = 26;
 // WiFiManager instance
 WiFiManager wifiManager;
 
+// Last good connection - RTC copy survives deep sleep, NVS copy survives resets and power loss
+#define WIFI_CACHE_MAGIC 0x57494643 // "WIFC"
+
+struct wifi_cache_t
+{
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+RTC_DATA_ATTR static wifi_cache_t wifi_cache;
+static Preferences wifi_prefs;
+
+// Connection state - events arrive on the WiFi event task, loop() acts on them
+static wifi_state_t wifi_state = WIFI_STATE_DISCONNECTED;
+static volatile bool event_got_ip = false;
+static volatile bool event_disconnected = false;
+static volatile uint8_t last_disconnect_reason = 0;
+static unsigned long next_connect_attempt = 0;
+static unsigned long connect_started = 0;
+static uint32_t last_connect_ms = 0; // Duration of the last successful connection attempt
+static bool attempt_cached = false;
+static unsigned long backoff_delay = WIFI_BACKOFF_MIN;
+static uint8_t failed_attempts = 0;
+
+// TX windows and radio-on estimate
+static unsigned long estimate_start = 0;
+static unsigned long last_tx_window = 0;
+static bool tx_window_used = false;
+static uint32_t tx_window_count = 0;
+static uint64_t tx_active_ms = 0;
+
+// WiFi event handler - runs on the WiFi event task, so only record what happened
+static void wifi_event_handler(WiFiEvent_t event, WiFiEventInfo_t info)
+{
+    switch (event)
+    {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        event_got_ip = true;
+        break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        last_disconnect_reason = info.wifi_sta_disconnected.reason;
+        event_disconnected = true;
+        break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+        event_disconnected = true;
+        break;
+    default:
+        break;
+    }
+}
+
 // Initialize WiFi manager
 void wifi_init()
 {
@@ -18,56 +75,266 @@ void wifi_init()
     digitalWrite(LED, LOW); // Set LED off initially
 
     // Set WiFiManager timeout (10 minutes)
-    wifiManager.setTimeout(600);
+    wifiManager.setTimeout(WIFI_PORTAL_TIMEOUT);
+
+    // Reconnection is driven by wifi_loop() rather than the WiFi driver. The core's own auto-reconnect is
+    // on by default and would retry on every disconnect event, ignoring the backoff; the WiFiManager
+    // setting only stops the portal from turning it back on.
+    WiFi.onEvent(wifi_event_handler);
+    WiFi.setAutoReconnect(false);
+    wifiManager.setWiFiAutoReconnect(false);
+
+    // Modem sleep - max mode honours the listen interval, min mode wakes for every DTIM beacon
+    WiFi.setSleep(WIFI_POWER_SAVE ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+    estimate_start = millis();
 }
 
-// Connect to WiFi using WiFiManager
-bool wifi_connect()
+// Load the connection cache, preferring the RTC copy
+static bool wifi_load_cache()
 {
-    // Automatic connection with fallback to setup page
-    if (!wifiManager.autoConnect(SSID, PASSWD))
+    if (wifi_cache.magic == WIFI_CACHE_MAGIC)
+    {
+        return true;
+    }
+
+    if (wifi_prefs.begin(WIFI_CACHE_NAMESPACE, true))
     {
-        Serial.println("Failed to connect, shut down WiFi-Modem for 3 Minutes then reset ESP32");
+        size_t length = wifi_prefs.getBytes("cache", &wifi_cache, sizeof(wifi_cache));
+        wifi_prefs.end();
+        if (length == sizeof(wifi_cache) && wifi_cache.magic == WIFI_CACHE_MAGIC)
+        {
+            return true;
+        }
+    }
 
-        // Turn off WiFi module
-        WiFi.disconnect();
-        WiFi.mode(WIFI_OFF);
-        delay(180000); // Wait 3 minutes with WiFi module off
-        ESP.restart(); // ESP32 uses restart() instead of reset()
-        return false;
+    wifi_cache.magic = 0;
+    return false;
+}
+
+// Remember the current access point and lease - NVS is only written when they changed
+static void wifi_save_cache()
+{
+    wifi_cache_t current;
+    memset(&current, 0, sizeof(current));
+    current.magic = WIFI_CACHE_MAGIC;
+    memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+    current.channel = WiFi.channel();
+    current.ip = WiFi.localIP();
+    current.gateway = WiFi.gatewayIP();
+    current.subnet = WiFi.subnetMask();
+    current.dns = WiFi.dnsIP();
+
+    bool changed = memcmp(&current, &wifi_cache, sizeof(current)) != 0;
+    wifi_cache = current;
+
+    if (changed && wifi_prefs.begin(WIFI_CACHE_NAMESPACE, false))
+    {
+        wifi_prefs.putBytes("cache", &wifi_cache, sizeof(wifi_cache));
+        wifi_prefs.end();
     }
+}
 
-    // Connection successful
-    digitalWrite(LED, HIGH); // Turn on LED (low active)
+// Start connecting with the stored credentials, directly to the cached AP when possible (non-blocking)
+static bool wifi_begin(bool use_cache)
+{
+    WiFi.mode(WIFI_STA);
 
+    // Adjust the stored driver configuration - WiFi.begin() then connects with it as-is
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) != ESP_OK || config.sta.ssid[0] == 0)
+    {
+        return false; // Never configured - only the portal can help
+    }
+    wifi_config_t previous = config;
+
+    bool cached = use_cache && wifi_load_cache();
+    config.sta.bssid_set = cached;
+    config.sta.channel = cached ? wifi_cache.channel : 0;
+    if (cached)
+    {
+        memcpy(config.sta.bssid, wifi_cache.bssid, sizeof(config.sta.bssid)); // Known AP - no scan
+    }
+
+    // Beacons to sleep through between wakes (only used with modem sleep)
+    config.sta.listen_interval = WIFI_POWER_SAVE ? WIFI_LISTEN_INTERVAL : 0;
+
+    // Only write when changed - the driver keeps the configuration in flash
+    if (memcmp(&config, &previous, sizeof(config)) != 0)
+    {
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+
+    if (WIFI_CACHE_STATIC_IP && cached)
+    {
+        WiFi.config(IPAddress(wifi_cache.ip), IPAddress(wifi_cache.gateway),
+                    IPAddress(wifi_cache.subnet), IPAddress(wifi_cache.dns));
+    }
+    else if (WIFI_CACHE_STATIC_IP)
+    {
+        WiFi.config(IPAddress(), IPAddress(), IPAddress()); // Back to DHCP
+    }
+
+    WiFi.begin();
     return true;
 }
 
+// Open the setup portal - served from process() in wifi_loop(), never blocks
+static void wifi_open_portal()
+{
+    failed_attempts = 0;
+    WiFi.disconnect();
+    wifiManager.setConfigPortalBlocking(false);
+    wifiManager.startConfigPortal(SSID, PASSWD);
+    wifi_state = WIFI_STATE_PORTAL;
+}
+
+// Start one connection attempt - the first after a success goes straight to the cached AP
+static void wifi_start_attempt()
+{
+    attempt_cached = (failed_attempts == 0) && wifi_load_cache();
+
+    if (!wifi_begin(attempt_cached))
+    {
+        Serial.println("No WiFi network configured, opening setup portal");
+        wifi_open_portal();
+        return;
+    }
+
+    connect_started = millis();
+    wifi_state = WIFI_STATE_CONNECTING;
+}
+
+// Start connecting in the background - progress is handled by wifi_loop()
+void wifi_start()
+{
+    backoff_delay = WIFI_BACKOFF_MIN;
+    failed_attempts = 0;
+    wifi_start_attempt();
+}
+
 // Check if WiFi is connected
 bool is_wifi_connected()
 {
     return (WiFi.status() == WL_CONNECTED) && (WiFi.localIP() != IPAddress(0, 0, 0, 0));
 }
 
-// Check WiFi connection and reset if lost
-void wifi_reset_if_lost()
+// Get WiFi connection state
+wifi_state_t get_wifi_state()
+{
+    return wifi_state;
+}
+
+// Schedule the next connection attempt with exponential backoff and jitter
+static void wifi_schedule_reconnect()
+{
+    digitalWrite(LED, LOW);
+    failed_attempts++;
+
+    if (failed_attempts >= WIFI_PORTAL_AFTER_FAILURES)
+    {
+        // Let the user enter new credentials
+        Serial.println("WiFi still unreachable, opening setup portal");
+        wifi_open_portal();
+        return;
+    }
+
+    // Spread attempts over 75-125% of the delay
+    unsigned long jitter = random(backoff_delay / 2 + 1);
+    unsigned long delay_ms = backoff_delay - backoff_delay / 4 + jitter;
+
+    next_connect_attempt = millis() + delay_ms;
+    wifi_state = WIFI_STATE_BACKOFF;
+
+    Serial.print("WiFi reconnect in ");
+    Serial.print(delay_ms);
+    Serial.println(" ms");
+
+    backoff_delay = min(backoff_delay * 2, (unsigned long)WIFI_BACKOFF_MAX);
+}
+
+// WiFi loop handler - reconnects in the background, must be called regularly
+void wifi_loop()
 {
-    // Only attempt reconnection if WiFi is actually disconnected
-    if (!is_wifi_connected())
+    bool got_ip = event_got_ip;
+    bool disconnected = event_disconnected;
+    event_got_ip = false;
+    event_disconnected = false;
+
+    switch (wifi_state)
     {
-        Serial.println("WiFi connection lost, attempting to reconnect...");
+    case WIFI_STATE_CONNECTED:
+        if (disconnected && !WiFi.isConnected())
+        {
+            Serial.print("WiFi connection lost, reason ");
+            Serial.println(last_disconnect_reason);
+            backoff_delay = WIFI_BACKOFF_MIN;
+            failed_attempts = 0;
+            next_connect_attempt = millis(); // First retry straight away
+            wifi_state = WIFI_STATE_BACKOFF;
+            digitalWrite(LED, LOW);
+        }
+        break;
+
+    case WIFI_STATE_DISCONNECTED:
+    case WIFI_STATE_BACKOFF:
+        if ((long)(millis() - next_connect_attempt) >= 0)
+        {
+            // Reconnect with the stored credentials - returns immediately
+            wifi_start_attempt();
+        }
+        break;
+
+    case WIFI_STATE_CONNECTING:
+        if (got_ip || is_wifi_connected())
+        {
+            last_connect_ms = millis() - connect_started;
+            Serial.print("WiFi connected in ");
+            Serial.print(last_connect_ms);
+            Serial.print(" ms, IP ");
+            Serial.println(WiFi.localIP());
+            digitalWrite(LED, HIGH);
+            backoff_delay = WIFI_BACKOFF_MIN;
+            failed_attempts = 0;
+            wifi_state = WIFI_STATE_CONNECTED;
+            wifi_save_cache();
+
+            // Don't wait out the MQTT backoff now that the network is back
+            mqtt_reconnect();
+        }
+        else if (attempt_cached && millis() - connect_started >= WIFI_FAST_CONNECT_TIMEOUT)
+        {
+            // AP moved to another channel or the lease is gone - scan right away
+            Serial.println("Cached WiFi network not reachable, falling back to full connect");
+            WiFi.disconnect();
+            failed_attempts++;
+            wifi_start_attempt();
+        }
+        else if (millis() - connect_started >= WIFI_CONNECT_TIMEOUT)
+        {
+            WiFi.disconnect();
+            wifi_schedule_reconnect();
+        }
+        break;
 
-        // Try to reconnect
-        if (!wifiManager.autoConnect(SSID, PASSWD))
+    case WIFI_STATE_PORTAL:
+        if (wifiManager.process())
         {
-            Serial.println("WiFi reconnection failed, restarting ESP32");
-            delay(3000);
-            ESP.restart();
+            // New credentials saved and connected
+            digitalWrite(LED, HIGH);
+            WiFi.setAutoReconnect(false);
+            backoff_delay = WIFI_BACKOFF_MIN;
+            wifi_state = WIFI_STATE_CONNECTED;
+            wifi_save_cache();
+            mqtt_reconnect();
         }
-        else
+        else if (!wifiManager.getConfigPortalActive())
         {
-            digitalWrite(LED, HIGH); // Turn on LED to indicate connection
+            // Portal timed out - go back to retrying the stored network
+            backoff_delay = WIFI_BACKOFF_MIN;
+            next_connect_attempt = millis();
+            wifi_state = WIFI_STATE_BACKOFF;
         }
+        break;
     }
 }
 
@@ -93,4 +360,56 @@ int32_t get_wifi_rssi()
 wl_status_t get_wifi_status()
 {
     return WiFi.status();
+}
+
+// Check if network outputs may be sent now - in power-save mode only once per TX window
+bool wifi_tx_window_due()
+{
+    if (!WIFI_POWER_SAVE)
+    {
+        return true;
+    }
+
+    if (tx_window_used && millis() - last_tx_window < WIFI_TX_WINDOW_MS)
+    {
+        return false;
+    }
+
+    last_tx_window = millis();
+    tx_window_used = true;
+    return true;
+}
+
+// Record how long the radio was busy sending in a TX window
+void wifi_tx_window_done(unsigned long active_ms)
+{
+    tx_window_count++;
+    tx_active_ms += active_ms + WIFI_TX_TAIL_MS;
+}
+
+// Estimate radio-on time per hour from beacon wakes and TX windows since boot
+uint32_t get_wifi_radio_on_ms_per_hour()
+{
+    uint64_t elapsed = millis() - estimate_start;
+    if (elapsed == 0)
+    {
+        return 0;
+    }
+
+    uint32_t wake_interval = WIFI_BEACON_INTERVAL_MS * (WIFI_POWER_SAVE ? WIFI_LISTEN_INTERVAL : 1);
+    uint64_t radio_on = (elapsed / wake_interval) * WIFI_BEACON_WAKE_MS + tx_active_ms;
+
+    return (uint32_t)(radio_on * 3600000ULL / elapsed);
+}
+
+// Get number of TX windows since boot
+uint32_t get_wifi_tx_window_count()
+{
+    return tx_window_count;
+}
+
+// Get the time the last successful connection attempt took in ms, 0 before the first
+uint32_t get_wifi_connect_ms()
+{
+    return last_connect_ms;
 }
\ No newline at end of file
@@ -5,12 +5,50 @@
 #include <WiFi.h>
 #include <DNSServer.h>
 #include <WiFiManager.h>
+#include <Preferences.h>
+#include <esp_wifi.h>
+
+// Power mode for battery/solar installs - modem sleep between beacons, outputs sent in short bursts
+#define WIFI_POWER_SAVE 0           // 1 = modem sleep with WIFI_LISTEN_INTERVAL, outputs grouped into TX windows
+#define WIFI_LISTEN_INTERVAL 10     // Wake for every 10th beacon (~1 s at the usual 102.4 ms beacon interval)
+#define WIFI_TX_WINDOW_MS 10000     // Network outputs are sent together at most this often
+#define WIFI_BEACON_INTERVAL_MS 102 // AP beacon interval, used for the radio-on estimate
+#define WIFI_BEACON_WAKE_MS 3       // Estimated radio-on time per beacon wake
+#define WIFI_TX_TAIL_MS 50          // Estimated time the radio stays awake after sending
+
+// Fast reconnect - reuse the last good access point instead of scanning
+#define WIFI_FAST_CONNECT_TIMEOUT 3000   // Fall back to a full connect if the cached AP doesn't answer
+#define WIFI_CACHE_STATIC_IP 0           // 1 = reuse the cached DHCP lease as a static IP (needs a DHCP reservation)
+#define WIFI_CACHE_NAMESPACE "wifi_cache"  // NVS namespace for the cache
+
+// Reconnection configuration - exponential backoff, never blocks loop()
+#define WIFI_BACKOFF_MIN 1000            // 1 second before the first retry
+#define WIFI_BACKOFF_MAX 60000           // Retry at least once a minute
+#define WIFI_CONNECT_TIMEOUT 15000       // Give up on an attempt without an IP after this long
+#define WIFI_PORTAL_AFTER_FAILURES 10    // Open the setup portal after this many failed attempts
+#define WIFI_PORTAL_TIMEOUT 600          // Seconds before an unused setup portal closes again
+
+// Connection states
+enum wifi_state_t
+{
+    WIFI_STATE_DISCONNECTED, // Not connected, no attempt scheduled yet
+    WIFI_STATE_BACKOFF,      // Waiting before the next attempt
+    WIFI_STATE_CONNECTING,   // Association/DHCP in progress
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_PORTAL        // Setup portal open (non-blocking), station retries paused
+};
 
 // Function declarations
 void wifi_init();
-bool wifi_connect();
+void wifi_start();
 bool is_wifi_connected();
-void wifi_reset_if_lost();
+wifi_state_t get_wifi_state();
+void wifi_loop();
+bool wifi_tx_window_due();
+void wifi_tx_window_done(unsigned long active_ms);
+uint32_t get_wifi_radio_on_ms_per_hour();
+uint32_t get_wifi_tx_window_count();
+uint32_t get_wifi_connect_ms();
 String get_wifi_ssid();
 IPAddress get_wifi_ip();
 int32_t get_wifi_rssi();
@@ -0,0 +1,24 @@
+/*
+ * Host shim for the parts of Arduino.h used by host-tested modules
+ *
+ * Only what those modules need: fixed-width types, the C string and
+ * memory functions, min()/max() and a clock. millis() and delay() are
+ * defined by each test, so a test can run a simulated clock.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+using std::max;
+using std::min;
+
+unsigned long millis();
+void delay(unsigned long ms);
+
+#endif // HOST_ARDUINO_H
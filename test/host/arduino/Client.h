@@ -0,0 +1,25 @@
+/*
+ * Host shim for Arduino's Client interface
+ *
+ * The byte-stream calls Mqtt5Client makes; a test derives from it to
+ * script what the "network" returns and to capture what was written.
+ */
+
+#ifndef HOST_CLIENT_H
+#define HOST_CLIENT_H
+
+#include "Arduino.h"
+
+class Client
+{
+public:
+    virtual ~Client() {}
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual size_t write(const uint8_t *data, size_t size) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+};
+
+#endif // HOST_CLIENT_H
@@ -0,0 +1,133 @@
+/*
+ * Binary payload benchmark (host)
+ *
+ * Compares the plain-text publishes of one sample (height, percent, XDR
+ * sentence) and of one status update (JSON status, WiFi and sensor
+ * status) with the packed CBOR record that carries the same data, in
+ * bytes on the wire (MQTT 3.1.1 PUBLISH, QoS 0) and encode time.
+ *   g++ -std=gnu++17 -O2 -Isrc test/host/bench_cbor.cpp src/cbor_writer.cpp src/json_writer.cpp -o bench_cbor && ./bench_cbor
+ */
+
+#include "cbor_writer.h"
+#include "json_writer.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_ENCODES 1000000
+
+// Same values as src/mqtt.h
+#define MQTT_CLIENT_ID "NMEA_Level_Sensor"
+#define MQTT_TOPIC_STATUS "sensors/level/status"
+#define MQTT_TOPIC_LEVEL_MM "sensors/level/height_mm"
+#define MQTT_TOPIC_LEVEL_PERCENT "sensors/level/percent"
+#define MQTT_TOPIC_NMEA_XDR "sensors/level/nmea_xdr"
+#define MQTT_TOPIC_WIFI_STATUS "sensors/level/wifi_status"
+#define MQTT_TOPIC_SENSOR_STATUS "sensors/level/sensor_status"
+#define MQTT_TOPIC_BINARY "sensors/level/bin"
+
+// Example sample
+#define SAMPLE_HEIGHT_MM 228
+#define SAMPLE_LEVEL_PERCENT 57
+#define SAMPLE_TIMESTAMP 3600000UL
+
+static volatile size_t sink; // Keeps the payloads from being optimised away
+
+// Size of a QoS 0 PUBLISH packet: fixed header, remaining length, topic and payload
+static size_t publish_size(const char *topic, size_t payload)
+{
+    size_t remaining = 2 + strlen(topic) + payload;
+    size_t length_bytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+    return 1 + length_bytes + remaining;
+}
+
+// XDR sentence as built by create_nmea_xdr()
+static size_t encode_xdr(char *buffer, size_t size, int level_percent)
+{
+    int len = snprintf(buffer, size, "$IIXDR,V,%d,P,FUEL*", level_percent);
+    int checksum = 0;
+    for (int i = 1; i < len - 1; i++)
+    {
+        checksum ^= (unsigned char)buffer[i];
+    }
+    len += snprintf(buffer + len, size - len, "%x", checksum);
+    return len;
+}
+
+// JSON status as built by mqtt_publish_json_data()
+static size_t encode_status(char *buffer, size_t size, bool wifi_connected, bool sensor_ok, unsigned long now)
+{
+    JsonWriter json(buffer, size);
+    json.beginObject();
+    json.addInt("height_mm", SAMPLE_HEIGHT_MM);
+    json.addInt("level_percent", SAMPLE_LEVEL_PERCENT);
+    json.addBool("wifi_connected", wifi_connected);
+    json.addBool("sensor_ok", sensor_ok);
+    json.addUInt("timestamp", now);
+    json.addString("client_id", MQTT_CLIENT_ID);
+    json.endObject();
+    return json.length();
+}
+
+// Plain-text publishes for one sample plus one status update - returns bytes on the wire
+static size_t encode_text(unsigned long now)
+{
+    char text[128];
+    size_t bytes = 0;
+
+    bytes += publish_size(MQTT_TOPIC_LEVEL_MM, snprintf(text, sizeof(text), "%d", SAMPLE_HEIGHT_MM));
+    bytes += publish_size(MQTT_TOPIC_LEVEL_PERCENT, snprintf(text, sizeof(text), "%d", SAMPLE_LEVEL_PERCENT));
+    bytes += publish_size(MQTT_TOPIC_NMEA_XDR, encode_xdr(text, sizeof(text), SAMPLE_LEVEL_PERCENT));
+    sink = text[0];
+
+    char status[384];
+    bytes += publish_size(MQTT_TOPIC_STATUS, encode_status(status, sizeof(status), true, true, now));
+    bytes += publish_size(MQTT_TOPIC_WIFI_STATUS, strlen("connected"));
+    bytes += publish_size(MQTT_TOPIC_SENSOR_STATUS, strlen("ok"));
+    sink = status[0];
+
+    return bytes;
+}
+
+// Packed record as built by mqtt_publish_binary_data() - returns bytes on the wire
+static size_t encode_binary(unsigned long now)
+{
+    uint8_t payload[64];
+    CborWriter cbor(payload, sizeof(payload));
+    cbor.beginMap(3);
+    cbor.addUInt(0);
+    cbor.addUInt(now);
+    cbor.addUInt(1);
+    cbor.addUInt(0x03); // WiFi connected, sensor OK
+    cbor.addUInt(2);
+    cbor.beginArray(1);
+    cbor.beginArray(3);
+    cbor.addUInt(0);
+    cbor.addInt(SAMPLE_HEIGHT_MM);
+    cbor.addInt(SAMPLE_LEVEL_PERCENT);
+    sink = payload[0];
+
+    return cbor.overflowed() ? 0 : publish_size(MQTT_TOPIC_BINARY, cbor.length());
+}
+
+// Time an encoder and print its wire size and encode time
+static void run(const char *name, size_t (*encode)(unsigned long))
+{
+    size_t bytes = encode(SAMPLE_TIMESTAMP);
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < BENCH_ENCODES; i++)
+    {
+        sink = encode(SAMPLE_TIMESTAMP + i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-32s %4zu bytes on the wire  %7.1f ns to encode\n", name, bytes, seconds * 1e9 / BENCH_ENCODES);
+}
+
+int main()
+{
+    run("Plain text (6 publishes)", encode_text);
+    run("CBOR record (1 publish)", encode_binary);
+    return EXIT_SUCCESS;
+}
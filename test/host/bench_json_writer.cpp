@@ -0,0 +1,208 @@
+/*
+ * JSON status payload benchmark (host)
+ *
+ * Builds the MQTT status payload the way mqtt_publish_json_data() used to
+ * (String concatenation, modelled by a small String class that grows its
+ * buffer on every append like Arduino's WString) and with JsonWriter, and
+ * reports bytes/s and heap allocations per publish. Also checks that the
+ * largest and smallest integers are written like printf writes them.
+ *   g++ -std=gnu++17 -O2 -Isrc test/host/bench_json_writer.cpp src/json_writer.cpp -o bench_json_writer && ./bench_json_writer
+ */
+
+#include "json_writer.h"
+#include <chrono>
+#include <limits.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <utility>
+
+#define BENCH_PUBLISHES 1000000
+#define BENCH_CLIENT_ID "NMEA_Level_Sensor" // MQTT_CLIENT_ID
+
+// Heap allocations, counted through global operator new
+static unsigned long allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// Minimal stand-in for Arduino's String - one heap buffer, reallocated to the exact length on every append
+class String
+{
+public:
+    String(const char *text = "") { append(text, strlen(text)); }
+    explicit String(long value)
+    {
+        char text[12];
+        snprintf(text, sizeof(text), "%ld", value);
+        append(text, strlen(text));
+    }
+    explicit String(unsigned long value)
+    {
+        char text[12];
+        snprintf(text, sizeof(text), "%lu", value);
+        append(text, strlen(text));
+    }
+    String(const String &other) { append(other.buffer, other.len); }
+    String(String &&other) noexcept : buffer(other.buffer), len(other.len)
+    {
+        other.buffer = NULL;
+        other.len = 0;
+    }
+    ~String() { delete[] buffer; }
+
+    String &operator+=(const String &other)
+    {
+        append(other.buffer, other.len);
+        return *this;
+    }
+    String &operator+=(const char *text)
+    {
+        append(text, strlen(text));
+        return *this;
+    }
+
+    // Like WString's StringSumHelper, a chain of + grows one temporary
+    friend String operator+(String lhs, const String &rhs) { return std::move(lhs += rhs); }
+    friend String operator+(String lhs, const char *rhs) { return std::move(lhs += rhs); }
+
+    const char *c_str() const { return buffer ? buffer : ""; }
+    size_t length() const { return len; }
+
+private:
+    void append(const char *text, size_t count)
+    {
+        char *grown = new char[len + count + 1];
+        if (buffer)
+        {
+            memcpy(grown, buffer, len);
+        }
+        memcpy(grown + len, text, count);
+        grown[len + count] = '\0';
+        delete[] buffer;
+        buffer = grown;
+        len += count;
+    }
+
+    char *buffer = NULL;
+    size_t len = 0;
+};
+
+static volatile size_t sink; // Keeps the payloads from being optimised away
+
+// Status payload as built before the streaming writer
+static size_t build_with_string(int height_mm, const String &level_percent, bool wifi_connected, bool sensor_ok, unsigned long now)
+{
+    String json = "{";
+    json += String("\"height_mm\":") + String((long)height_mm) + ",";
+    json += String("\"level_percent\":") + level_percent + ",";
+    json += String("\"wifi_connected\":") + String(wifi_connected ? "true" : "false") + ",";
+    json += String("\"sensor_ok\":") + String(sensor_ok ? "true" : "false") + ",";
+    json += String("\"timestamp\":") + String(now) + ",";
+    json += String("\"client_id\":\"") + String(BENCH_CLIENT_ID) + "\"";
+    json += "}";
+    sink = json.c_str()[0];
+    return json.length();
+}
+
+// Status payload as built by mqtt_publish_json_data()
+static size_t build_with_writer(int height_mm, long level_percent, bool wifi_connected, bool sensor_ok, unsigned long now)
+{
+    char payload[384];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject();
+    json.addInt("height_mm", height_mm);
+    json.addInt("level_percent", level_percent);
+    json.addBool("wifi_connected", wifi_connected);
+    json.addBool("sensor_ok", sensor_ok);
+    json.addUInt("timestamp", now);
+    json.addString("client_id", BENCH_CLIENT_ID);
+    json.endObject();
+    sink = json.c_str()[0];
+    return json.overflowed() ? 0 : json.length();
+}
+
+// Integer limits must match printf (unsigned long is 64-bit on LP64 hosts)
+static bool check_limits()
+{
+    char payload[64];
+    char expected[64];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginArray();
+    json.addUInt(NULL, ULONG_MAX);
+    json.addInt(NULL, LONG_MIN);
+    json.endArray();
+    snprintf(expected, sizeof(expected), "[%lu,%ld]", ULONG_MAX, LONG_MIN);
+    bool ok = !json.overflowed() && strcmp(payload, expected) == 0;
+    printf("%-22s %s %s\n", "Integer limits", payload, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Print one result line
+static void report(const char *name, size_t bytes, unsigned long allocs, double seconds)
+{
+    printf("%-22s %3zu bytes  %5.1f allocations/publish  %7.1f ns/publish  %7.1f MB/s\n", name,
+           bytes / BENCH_PUBLISHES, (double)allocs / BENCH_PUBLISHES, seconds * 1e9 / BENCH_PUBLISHES,
+           bytes / seconds / 1e6);
+}
+
+int main()
+{
+    String level_text("57");
+
+    unsigned long allocs_before = allocations;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < BENCH_PUBLISHES; i++)
+    {
+        bytes += build_with_string(228, level_text, true, true, 3600000 + i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("String concatenation", bytes, allocations - allocs_before, seconds);
+
+    allocs_before = allocations;
+    bytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < BENCH_PUBLISHES; i++)
+    {
+        bytes += build_with_writer(228, 57, true, true, 3600000 + i);
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("JsonWriter", bytes, allocations - allocs_before, seconds);
+
+    bool ok = check_limits();
+    return ok && allocations == allocs_before ? EXIT_SUCCESS : EXIT_FAILURE;
+}
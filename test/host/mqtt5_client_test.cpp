@@ -0,0 +1,208 @@
+/*
+ * MQTT 5 client encode/decode test (host)
+ *
+ * Runs Mqtt5Client against a scripted in-memory connection: checks the
+ * CONNECT it writes, topic alias handling on PUBLISH, delivery of an
+ * inbound PUBLISH, and that malformed or truncated CONNACKs are rejected
+ * without reading past the packet. Build with AddressSanitizer so an
+ * out-of-bounds read fails the run:
+ *   g++ -std=gnu++17 -O1 -g -fsanitize=address -Isrc -Itest/host/arduino test/host/mqtt5_client_test.cpp src/mqtt5_client.cpp -o mqtt5_client_test && ./mqtt5_client_test
+ */
+
+#include "mqtt5_client.h"
+#include <deque>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Smallest buffer that takes a CONNECT for client id "t", so a CONNACK
+// of MAX_CONNACK bytes fills it to the last byte
+#define BUFFER_SIZE 28
+#define MAX_CONNACK (BUFFER_SIZE - 5)
+
+typedef std::vector<uint8_t> bytes_t;
+
+static unsigned long fake_clock = 0;
+static int failures = 0;
+
+unsigned long millis()
+{
+    return fake_clock;
+}
+
+void delay(unsigned long ms)
+{
+    fake_clock += ms;
+}
+
+// Connection that serves scripted input and records what is written
+class FakeClient : public Client
+{
+public:
+    std::deque<uint8_t> input;
+    bytes_t output;
+    bool open = false;
+
+    int connect(const char *host, uint16_t port) override
+    {
+        open = true;
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t size) override
+    {
+        output.insert(output.end(), data, data + size);
+        return size;
+    }
+    int available() override
+    {
+        return input.size();
+    }
+    int read() override
+    {
+        if (input.empty())
+        {
+            return -1;
+        }
+        uint8_t value = input.front();
+        input.pop_front();
+        return value;
+    }
+    void stop() override
+    {
+        open = false;
+    }
+    uint8_t connected() override
+    {
+        return open;
+    }
+};
+
+static void check(bool ok, const char *what)
+{
+    printf("%-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+// Queue a packet with its fixed header (remaining length < 128)
+static void queue_packet(FakeClient &net, uint8_t type, const bytes_t &body)
+{
+    net.input.push_back(type);
+    net.input.push_back(body.size());
+    net.input.insert(net.input.end(), body.begin(), body.end());
+}
+
+// Pad a CONNACK body with zero bytes so it fills the client buffer
+static bytes_t fill(bytes_t body)
+{
+    body.resize(MAX_CONNACK, 0);
+    return body;
+}
+
+static bool connect_with(FakeClient &net, Mqtt5Client &mqtt, const bytes_t &connack)
+{
+    net.output.clear();
+    net.input.clear();
+    net.open = false;
+    queue_packet(net, 0x20, connack);
+    return mqtt.connect("t");
+}
+
+static char received_topic[64];
+static std::string received_payload;
+
+static void on_message(char *topic, uint8_t *payload, unsigned int length)
+{
+    snprintf(received_topic, sizeof(received_topic), "%s", topic);
+    received_payload.assign((const char *)payload, length);
+}
+
+static void test_connect_and_publish()
+{
+    FakeClient net;
+    Mqtt5Client mqtt(net);
+    mqtt.setServer("broker", 1883).setKeepAlive(60).setCallback(on_message);
+    mqtt.setBufferSize(64);
+
+    // CONNACK: no session present, success, topic alias maximum 4
+    check(connect_with(net, mqtt, {0x00, 0x00, 0x03, 0x22, 0x00, 0x04}), "CONNACK with topic alias maximum accepted");
+
+    const bytes_t connect = {
+        0x10, 22,                           // CONNECT, remaining length
+        0x00, 0x04, 'M', 'Q', 'T', 'T', 5,  // Protocol name and level
+        0x02, 0x00, 60,                     // Clean start, keep alive
+        8, 0x21, 0x00, 64, 0x27, 0, 0, 0, 64, // Receive maximum, maximum packet size
+        0x00, 0x01, 't'};                   // Client identifier
+    check(net.output == connect, "CONNECT encoding");
+
+    net.output.clear();
+    mqtt.publish("a/b", "x");
+    const bytes_t first = {0x30, 10, 0x00, 0x03, 'a', '/', 'b', 3, 0x23, 0x00, 0x01, 'x'};
+    check(net.output == first, "first PUBLISH carries topic and new alias");
+
+    net.output.clear();
+    mqtt.publish("a/b", "y");
+    const bytes_t second = {0x30, 7, 0x00, 0x00, 3, 0x23, 0x00, 0x01, 'y'};
+    check(net.output == second, "second PUBLISH carries alias only");
+
+    queue_packet(net, 0x30, {0x00, 0x03, 'c', '/', 'd', 0x00, 'o', 'n'});
+    mqtt.loop();
+    check(strcmp(received_topic, "c/d") == 0 && received_payload == "on", "inbound PUBLISH decoded");
+
+    // Without a topic alias maximum the broker allows no aliases
+    check(connect_with(net, mqtt, {0x00, 0x00, 0x00}), "CONNACK without properties accepted");
+    net.output.clear();
+    mqtt.publish("a/b", "x");
+    const bytes_t plain = {0x30, 7, 0x00, 0x03, 'a', '/', 'b', 0, 'x'};
+    check(net.output == plain, "no alias when the broker allows none");
+}
+
+static void test_malformed_connack()
+{
+    FakeClient net;
+    Mqtt5Client mqtt(net);
+    mqtt.setServer("broker", 1883);
+    mqtt.setBufferSize(BUFFER_SIZE);
+
+    struct
+    {
+        const char *what;
+        bytes_t connack;
+    } cases[] = {
+        {"too short", {0x00, 0x00}},
+        {"property length varint runs past the packet", fill({0x00, 0x00, 0x80, 0x80, 0x80, 0x80})},
+        {"property length varint ends at the packet", {0x00, 0x00, 0x80}},
+        {"property length past the packet", fill({0x00, 0x00, 0x7F})},
+        {"fixed-size property cut short", {0x00, 0x00, 0x02, 0x22, 0x00}},
+        {"string length past the properties", fill({0x00, 0x00, MAX_CONNACK - 3, 0x1F, 0x00, 0xFF})},
+        {"string length prefix cut short", {0x00, 0x00, 0x02, 0x1F, 0x00}},
+        {"user property missing its value", {0x00, 0x00, 0x04, 0x26, 0x00, 0x01, 'k'}},
+        {"unknown property", {0x00, 0x00, 0x02, 0x7F, 0x00}},
+        {"refused by the broker", {0x00, 0x87, 0x00}},
+    };
+
+    for (auto &c : cases)
+    {
+        bool accepted = connect_with(net, mqtt, c.connack);
+        check(!accepted && !mqtt.connected() && !net.open, c.what);
+    }
+    check(mqtt.state() == 0x87, "reason code reported as state");
+
+    // A complete CONNACK that fills the buffer is still accepted
+    bytes_t full = {0x00, 0x00, MAX_CONNACK - 3, 0x26, 0x00, 0x01, 'k'};
+    full.push_back(0x00);
+    full.push_back(MAX_CONNACK - full.size() - 1);
+    full.resize(MAX_CONNACK, 'v');
+    check(connect_with(net, mqtt, full), "user property filling the buffer accepted");
+}
+
+int main()
+{
+    test_connect_and_publish();
+    test_malformed_connack();
+
+    printf("\n%s\n", failures ? "FAILED" : "all passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Seqlock stress test (host)
+ *
+ * One writer thread publishes records whose fields are all derived from a
+ * counter while reader threads copy them as fast as possible; every copy
+ * that returns must be internally consistent. Exits non-zero on a torn read.
+ *   g++ -std=gnu++17 -O2 -pthread -Isrc test/host/seqlock_stress.cpp -o seqlock_stress && ./seqlock_stress
+ * Build with -fsanitize=thread -Wno-tsan as well to check that the accesses are race-free.
+ */
+
+#include "seqlock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Same layout as sensor_snapshot_t
+struct record_t
+{
+    uint32_t sample;
+    int height_mm;
+    int level_percent;
+    bool sensor_ok;
+    uint32_t timestamp_ms;
+    uint32_t check;
+};
+
+#define STRESS_WRITES 5000000
+#define STRESS_READERS 3
+
+static seqlock_t lock = {};
+static std::atomic<bool> done(false);
+
+// Writer - every field follows from the sample counter
+static void writer()
+{
+    record_t record = {};
+    for (uint32_t n = 1; n <= STRESS_WRITES; n++)
+    {
+        record.sample = n;
+        record.height_mm = n * 7;
+        record.level_percent = n % 101;
+        record.sensor_ok = n & 1;
+        record.timestamp_ms = ~n;
+        record.check = n * 2654435761u;
+        seqlock_write(&lock, &record, sizeof(record));
+    }
+    done = true;
+}
+
+// Reader - counts successful copies, retries and inconsistent copies
+static void reader(uint64_t *reads, uint64_t *retries, uint64_t *torn)
+{
+    while (!done)
+    {
+        record_t record;
+        if (!seqlock_try_read(&lock, &record, sizeof(record)))
+        {
+            (*retries)++;
+            continue;
+        }
+        (*reads)++;
+
+        uint32_t n = record.sample;
+        if (n == 0)
+        {
+            continue; // Nothing written yet
+        }
+        if (record.height_mm != (int)(n * 7) || record.level_percent != (int)(n % 101) ||
+            record.sensor_ok != (bool)(n & 1) || record.timestamp_ms != ~n || record.check != n * 2654435761u)
+        {
+            (*torn)++;
+        }
+    }
+}
+
+int main()
+{
+    uint64_t reads[STRESS_READERS] = {}, retries[STRESS_READERS] = {}, torn[STRESS_READERS] = {};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < STRESS_READERS; i++)
+    {
+        threads.emplace_back(reader, &reads[i], &retries[i], &torn[i]);
+    }
+    threads.emplace_back(writer);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    uint64_t total_reads = 0, total_retries = 0, total_torn = 0;
+    for (int i = 0; i < STRESS_READERS; i++)
+    {
+        total_reads += reads[i];
+        total_retries += retries[i];
+        total_torn += torn[i];
+    }
+
+    printf("%d writes, %llu reads, %llu retries, %llu torn\n", STRESS_WRITES, (unsigned long long)total_reads,
+           (unsigned long long)total_retries, (unsigned long long)total_torn);
+    return total_torn == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}